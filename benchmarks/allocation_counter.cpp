@@ -0,0 +1,68 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+
+/**
+ * Allocation functions of the C library are replaced by counting wrappers
+ * around the glibc implementation. Since the executable defines them, they are
+ * also used by shared libraries and by operator new.
+ */
+#ifdef __GLIBC__
+static std::atomic<uint64_t> nb_allocations(0);
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t nb_elements, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size)
+{
+  nb_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t nb_elements, size_t size)
+{
+  nb_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(nb_elements, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+  nb_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+  nb_allocations.fetch_add(1, std::memory_order_relaxed);
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr == nullptr ? ENOMEM : 0;
+}
+}
+#endif
+
+namespace hl_monitoring
+{
+bool isCountingAllocations()
+{
+#ifdef __GLIBC__
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t getNbAllocations()
+{
+#ifdef __GLIBC__
+  return nb_allocations.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+}  // namespace hl_monitoring
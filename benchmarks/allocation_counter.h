@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace hl_monitoring
+{
+/**
+ * Return true if heap allocations are counted on this platform
+ */
+bool isCountingAllocations();
+
+/**
+ * Number of calls to malloc, calloc, realloc and posix_memalign since the
+ * start of the process, in all threads and all libraries (OpenCV, protobuf...)
+ */
+uint64_t getNbAllocations();
+
+}  // namespace hl_monitoring
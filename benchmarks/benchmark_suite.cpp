@@ -0,0 +1,161 @@
+#include "benchmark_suite.h"
+
+#include "allocation_counter.h"
+
+#include <hl_communication/utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace hl_monitoring
+{
+Json::Value BenchmarkSuite::Result::toJson() const
+{
+  Json::Value v;
+  v["name"] = name;
+  v["iterations"] = nb_iterations;
+  v["items_per_iteration"] = (Json::UInt64)items_per_iteration;
+  v["mean_ns"] = mean;
+  v["median_ns"] = median;
+  v["min_ns"] = min;
+  v["max_ns"] = max;
+  v["stddev_ns"] = stddev;
+  v["median_ns_per_item"] = median / items_per_iteration;
+  v["cpu_ns"] = cpu_time;
+  v["allocations_per_iteration"] = allocations;
+  if (!metrics.isNull())
+  {
+    v["metrics"] = metrics;
+  }
+  return v;
+}
+
+BenchmarkSuite::BenchmarkSuite(double min_duration_, int min_iterations_, const std::string& filter_)
+  : min_duration(min_duration_), min_iterations(min_iterations_), filter(filter_)
+{
+  char date[32];
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+  context["date"] = date;
+  context["compiler"] = __VERSION__;
+#ifdef NDEBUG
+  context["assertions"] = false;
+#else
+  context["assertions"] = true;
+#endif
+  context["hardware_threads"] = std::thread::hardware_concurrency();
+  context["counting_allocations"] = isCountingAllocations();
+  context["min_duration_s"] = min_duration;
+  context["min_iterations"] = min_iterations;
+}
+
+bool BenchmarkSuite::isEnabled(const std::string& name) const
+{
+  return name.find(filter) != std::string::npos;
+}
+
+void BenchmarkSuite::run(const std::string& name, size_t items_per_iteration, const std::function<void()>& iteration)
+{
+  if (!isEnabled(name))
+  {
+    return;
+  }
+  if (items_per_iteration == 0)
+  {
+    throw std::logic_error(HL_DEBUG + "no items for benchmark '" + name + "'");
+  }
+  typedef std::chrono::steady_clock clock;
+  // Warm-up: caches, lazy initializations and page faults
+  iteration();
+  std::vector<double> durations;
+  double elapsed = 0;
+  uint64_t nb_allocations = 0;
+  std::clock_t cpu_start = std::clock();
+  while (elapsed < min_duration || (int)durations.size() < min_iterations)
+  {
+    uint64_t allocations_start = getNbAllocations();
+    clock::time_point start = clock::now();
+    iteration();
+    clock::time_point end = clock::now();
+    nb_allocations += getNbAllocations() - allocations_start;
+    double duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    durations.push_back(duration);
+    elapsed += duration * 1e-9;
+  }
+  std::clock_t cpu_end = std::clock();
+  Result result;
+  result.name = name;
+  result.nb_iterations = durations.size();
+  result.items_per_iteration = items_per_iteration;
+  result.cpu_time = (cpu_end - cpu_start) * (1e9 / CLOCKS_PER_SEC) / durations.size();
+  result.allocations = nb_allocations / (double)durations.size();
+  double sum = 0, sum2 = 0;
+  for (double duration : durations)
+  {
+    sum += duration;
+    sum2 += duration * duration;
+  }
+  result.mean = sum / durations.size();
+  result.stddev = std::sqrt(std::max(0.0, sum2 / durations.size() - result.mean * result.mean));
+  std::sort(durations.begin(), durations.end());
+  result.median = durations[durations.size() / 2];
+  result.min = durations.front();
+  result.max = durations.back();
+  results.push_back(result);
+  std::cout << std::left << std::setw(48) << name << std::right << std::setw(10) << result.nb_iterations
+            << std::setw(16) << std::fixed << std::setprecision(1) << (result.median / items_per_iteration)
+            << " ns/item" << std::setw(16) << std::setprecision(1) << result.cpu_time << " cpu ns/iter" << std::setw(12)
+            << std::setprecision(2) << result.allocations << " allocs/iter"
+            << std::endl;
+}
+
+void BenchmarkSuite::setMetric(const std::string& name, const std::string& key, double value)
+{
+  for (auto it = results.rbegin(); it != results.rend(); it++)
+  {
+    if (it->name == name)
+    {
+      it->metrics[key] = value;
+      return;
+    }
+  }
+}
+
+void BenchmarkSuite::setContext(const std::string& key, const Json::Value& value)
+{
+  context[key] = value;
+}
+
+const std::vector<BenchmarkSuite::Result>& BenchmarkSuite::getResults() const
+{
+  return results;
+}
+
+Json::Value BenchmarkSuite::toJson() const
+{
+  Json::Value v;
+  v["context"] = context;
+  v["benchmarks"] = Json::Value(Json::arrayValue);
+  for (const Result& result : results)
+  {
+    v["benchmarks"].append(result.toJson());
+  }
+  return v;
+}
+
+void BenchmarkSuite::writeJson(const std::string& path) const
+{
+  std::ofstream out(path);
+  if (!out.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "failed to open file '" + path + "'");
+  }
+  out << toJson() << std::endl;
+}
+
+}  // namespace hl_monitoring
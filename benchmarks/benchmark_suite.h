@@ -0,0 +1,137 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Runs named benchmarks and collects their timings in a machine-readable form.
+ *
+ * Each benchmark is a function performing one iteration of the measured
+ * operation on a given number of items. After a warm-up iteration, the
+ * function is called until both the minimal duration and the minimal number of
+ * iterations are reached. Statistics are computed on the duration of the
+ * iterations, durations per item are provided to compare runs with different
+ * batch sizes. Heap allocations performed during the measured iterations are
+ * counted.
+ */
+class BenchmarkSuite
+{
+public:
+  struct Result
+  {
+    std::string name;
+    int nb_iterations;
+    /**
+     * Number of items processed during each iteration (frames, points, lookups...)
+     */
+    size_t items_per_iteration;
+    /**
+     * Statistics on the durations of iterations [ns]
+     */
+    double mean;
+    double median;
+    double min;
+    double max;
+    double stddev;
+    /**
+     * Average CPU time consumed by the process per iteration, includes the
+     * work of all the threads [ns]
+     */
+    double cpu_time;
+    /**
+     * Average number of heap allocations per iteration, see getNbAllocations
+     */
+    double allocations;
+    /**
+     * Additional measures provided by the benchmark, e.g. size of outputs
+     */
+    Json::Value metrics;
+
+    Json::Value toJson() const;
+  };
+
+  /**
+   * min_duration: minimal time spent in each benchmark [s]
+   * min_iterations: minimal number of iterations of each benchmark
+   * filter: only benchmarks whose name contains filter are run
+   */
+  BenchmarkSuite(double min_duration = 1.0, int min_iterations = 10, const std::string& filter = "");
+
+  /**
+   * Return true if the benchmark with the given name would be run, allows to
+   * skip costly preparations
+   */
+  bool isEnabled(const std::string& name) const;
+
+  /**
+   * Run the benchmark if it is enabled, print a summary on standard output and
+   * store the result
+   */
+  void run(const std::string& name, size_t items_per_iteration, const std::function<void()>& iteration);
+
+  /**
+   * Add a custom measure to the result of the benchmark with the given name,
+   * ignored if the benchmark has not been run
+   */
+  void setMetric(const std::string& name, const std::string& key, double value);
+
+  /**
+   * Add a description of the context to the results, e.g. input files
+   */
+  void setContext(const std::string& key, const Json::Value& value);
+
+  const std::vector<Result>& getResults() const;
+
+  /**
+   * Return the context of the run (compiler, build type, date, custom entries)
+   * and the results of all the benchmarks
+   */
+  Json::Value toJson() const;
+
+  void writeJson(const std::string& path) const;
+
+private:
+  double min_duration;
+  int min_iterations;
+  std::string filter;
+
+  Json::Value context;
+
+  std::vector<Result> results;
+};
+
+/**
+ * Prevents the compiler from optimizing away a computed value
+ */
+template <typename T>
+void doNotOptimize(const T& value)
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * Benchmarks relying only on synthetic data: projections, overlays and top view
+ */
+void runGeometryBenchmarks(BenchmarkSuite* suite);
+
+/**
+ * Benchmarks of the replay of a recorded video along with its meta information,
+ * the monitoring manager is benchmarked with nb_providers providers replaying
+ * the same video
+ */
+void runReplayBenchmarks(BenchmarkSuite* suite, const std::string& video_path, const std::string& meta_path,
+                         int nb_providers);
+
+/**
+ * Encoding of synthetic images with all the encoder presets, videos are written
+ * in output_dir and removed afterwards
+ */
+void runEncoderBenchmarks(BenchmarkSuite* suite, const std::string& output_dir);
+
+}  // namespace hl_monitoring
@@ -0,0 +1,84 @@
+#include "benchmark_suite.h"
+
+#include <hl_monitoring/encoder_settings.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace hl_monitoring
+{
+/**
+ * Frames similar to a field seen by a camera: a green background with lines,
+ * moving blobs and sensor noise, compression ratio is meaningful
+ */
+static std::vector<cv::Mat> buildFrames(int nb_frames, const cv::Size& size)
+{
+  cv::RNG rng(42);
+  std::vector<cv::Mat> frames;
+  for (int frame_idx = 0; frame_idx < nb_frames; frame_idx++)
+  {
+    cv::Mat img(size, CV_8UC3, cv::Scalar(40, 140, 50));
+    cv::line(img, cv::Point(0, size.height / 2), cv::Point(size.width, size.height / 2), cv::Scalar(255, 255, 255), 5);
+    cv::circle(img, cv::Point(size.width / 2, size.height / 2), size.height / 5, cv::Scalar(255, 255, 255), 5);
+    int offset = frame_idx * 8;
+    cv::circle(img, cv::Point((100 + offset) % size.width, size.height / 3), 20, cv::Scalar(0, 0, 0), -1);
+    cv::rectangle(img, cv::Rect(size.width - 150 - offset % size.width / 2, 2 * size.height / 3, 40, 80),
+                  cv::Scalar(30, 30, 200), -1);
+    cv::Mat noise(size, CV_8UC3);
+    rng.fill(noise, cv::RNG::NORMAL, 0, 6);
+    img += noise;
+    frames.push_back(img);
+  }
+  return frames;
+}
+
+void runEncoderBenchmarks(BenchmarkSuite* suite, const std::string& output_dir)
+{
+  const cv::Size size(1280, 720);
+  const double fps = 30;
+  std::vector<cv::Mat> frames;
+  for (const std::string& preset : EncoderSettings::getPresetNames())
+  {
+    std::string name = "encoder/" + preset;
+    if (!suite->isEnabled(name))
+    {
+      continue;
+    }
+    if (frames.empty())
+    {
+      frames = buildFrames(60, size);
+    }
+    EncoderSettings settings = EncoderSettings::getPreset(preset);
+    std::string path = settings.getPath(output_dir + "/hl_monitoring_benchmark_" + preset);
+    size_t nb_written = 0;
+    {
+      cv::VideoWriter writer;
+      try
+      {
+        settings.open(path, fps, size, true, &writer);
+      }
+      catch (const std::runtime_error& exc)
+      {
+        std::cerr << "Skipping " << name << ": " << exc.what() << std::endl;
+        continue;
+      }
+      suite->run(name, 1, [&]() {
+        writer.write(frames[nb_written % frames.size()]);
+        nb_written++;
+      });
+      // Flushes the frames delayed by the encoder before measuring the size
+      writer.release();
+    }
+    struct stat file_stat;
+    if (nb_written > 0 && stat(path.c_str(), &file_stat) == 0)
+    {
+      suite->setMetric(name, "bytes_per_frame", file_stat.st_size / (double)nb_written);
+    }
+    std::remove(path.c_str());
+  }
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,96 @@
+#include "benchmark_suite.h"
+
+#include <hl_monitoring/field.h>
+#include <hl_monitoring/field_overlay_cache.h>
+#include <hl_monitoring/top_view_drawer.h>
+
+#include <random>
+
+namespace hl_monitoring
+{
+/**
+ * Camera placed on the side of the field, looking at its center
+ */
+static CameraMetaInformation buildCamera(int distortion_size)
+{
+  std::vector<double> coefficients = { -0.25, 0.08, 0.001, -0.0005, -0.01, 0.02, -0.005, 0.001 };
+  CameraMetaInformation camera_meta;
+  IntrinsicParameters* intrinsic = camera_meta.mutable_camera_parameters();
+  intrinsic->set_focal_x(700);
+  intrinsic->set_focal_y(700);
+  intrinsic->set_center_x(640);
+  intrinsic->set_center_y(360);
+  intrinsic->set_img_width(1280);
+  intrinsic->set_img_height(720);
+  for (int idx = 0; idx < distortion_size; idx++)
+  {
+    intrinsic->add_distortion(coefficients[idx]);
+  }
+  std::vector<double> rotation = { -2.0, 0, 0 };
+  std::vector<double> translation = { 0, 1.5, 6.0 };
+  Pose3D* pose = camera_meta.mutable_pose();
+  for (int idx = 0; idx < 3; idx++)
+  {
+    pose->add_rotation(rotation[idx]);
+    pose->add_translation(translation[idx]);
+  }
+  return camera_meta;
+}
+
+void runGeometryBenchmarks(BenchmarkSuite* suite)
+{
+  Field field;
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<float> x_distrib(-field.getArenaLength() / 2, field.getArenaLength() / 2);
+  std::uniform_real_distribution<float> y_distrib(-field.getArenaWidth() / 2, field.getArenaWidth() / 2);
+  const size_t nb_points = 10000;
+  std::vector<cv::Point3f> pos_in_field;
+  for (size_t idx = 0; idx < nb_points; idx++)
+  {
+    pos_in_field.push_back(cv::Point3f(x_distrib(engine), y_distrib(engine), 0));
+  }
+  std::vector<cv::Point2f> pos_in_img(nb_points);
+
+  for (int distortion_size : { 0, 5 })
+  {
+    std::string suffix = "/distortion_" + std::to_string(distortion_size);
+    CameraModel model(buildCamera(distortion_size));
+    suite->run("camera_model/field_to_img" + suffix, nb_points, [&]() {
+      model.fieldToImg(pos_in_field.data(), nb_points, pos_in_img.data());
+      doNotOptimize(pos_in_img);
+    });
+    suite->run("camera_model/field_to_img_single" + suffix, nb_points, [&]() {
+      for (size_t idx = 0; idx < nb_points; idx++)
+      {
+        pos_in_img[idx] = model.fieldToImg(pos_in_field[idx]);
+      }
+      doNotOptimize(pos_in_img);
+    });
+
+    cv::Mat img(model.getImgSize(), CV_8UC3, cv::Scalar(0, 0, 0));
+    suite->run("field/tag_lines" + suffix, 1, [&]() {
+      field.tagLines(model, &img, cv::Scalar(255, 0, 255), 2.0, 10);
+      doNotOptimize(img.data);
+    });
+
+    std::shared_ptr<const CameraModel> shared_model = std::make_shared<CameraModel>(buildCamera(distortion_size));
+    FieldOverlayCache overlay_cache;
+    suite->run("field_overlay_cache/tag_lines" + suffix, 1, [&]() {
+      overlay_cache.tagLines("camera", field, shared_model, &img, cv::Scalar(255, 0, 255), 2.0, 10);
+      doNotOptimize(img.data);
+    });
+  }
+
+  TopViewDrawer drawer;
+  suite->run("top_view_drawer/get_img", 1, [&]() {
+    cv::Mat top_view = drawer.getImg(field);
+    doNotOptimize(top_view.data);
+  });
+  cv::Mat top_view;
+  suite->run("top_view_drawer/get_img_reused", 1, [&]() {
+    drawer.getImg(field, &top_view);
+    doNotOptimize(top_view.data);
+  });
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,60 @@
+/**
+ * Runs the benchmarks of hl_monitoring and writes the results as JSON, allowing
+ * to compare performances between versions.
+ *
+ * Geometry and encoder benchmarks use synthetic data, replay benchmarks require a
+ * video and its meta information.
+ */
+#include "benchmark_suite.h"
+
+#include <tclap/CmdLine.h>
+
+#include <iostream>
+
+using namespace hl_monitoring;
+
+int main(int argc, char** argv)
+{
+  TCLAP::CmdLine cmd("Benchmarks of hl_monitoring", ' ', "0.9");
+  TCLAP::ValueArg<std::string> output_arg("o", "output", "Path to the JSON output", false,
+                                          "hl_monitoring_benchmarks.json", "string", cmd);
+  TCLAP::ValueArg<std::string> video_arg("v", "video", "Video used for replay benchmarks", false, "", "string", cmd);
+  TCLAP::ValueArg<std::string> meta_arg("m", "meta", "Meta information of the video", false, "", "string", cmd);
+  TCLAP::ValueArg<int> providers_arg("n", "providers", "Number of providers used by the monitoring manager", false, 4,
+                                     "int", cmd);
+  TCLAP::ValueArg<std::string> filter_arg("f", "filter", "Only run benchmarks containing this string", false, "",
+                                          "string", cmd);
+  TCLAP::ValueArg<double> duration_arg("d", "duration", "Minimal duration of each benchmark [s]", false, 1.0,
+                                       "double", cmd);
+  TCLAP::ValueArg<int> iterations_arg("i", "iterations", "Minimal number of iterations of each benchmark", false, 10,
+                                      "int", cmd);
+  TCLAP::ValueArg<std::string> work_dir_arg("w", "work-dir", "Directory where temporary videos are encoded", false,
+                                            "/tmp", "string", cmd);
+  TCLAP::ValueArg<std::string> label_arg("l", "label", "Label of the run, e.g. a commit", false, "", "string", cmd);
+
+  try
+  {
+    cmd.parse(argc, argv);
+  }
+  catch (const TCLAP::ArgException& e)
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  BenchmarkSuite suite(duration_arg.getValue(), iterations_arg.getValue(), filter_arg.getValue());
+  suite.setContext("label", label_arg.getValue());
+  runGeometryBenchmarks(&suite);
+  runEncoderBenchmarks(&suite, work_dir_arg.getValue());
+  if (video_arg.getValue() != "" && meta_arg.getValue() != "")
+  {
+    suite.setContext("video", video_arg.getValue());
+    suite.setContext("meta", meta_arg.getValue());
+    runReplayBenchmarks(&suite, video_arg.getValue(), meta_arg.getValue(), providers_arg.getValue());
+  }
+  else
+  {
+    std::cerr << "No video or meta information provided: skipping replay benchmarks" << std::endl;
+  }
+  suite.writeJson(output_arg.getValue());
+}
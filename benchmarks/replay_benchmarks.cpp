@@ -0,0 +1,111 @@
+#include "benchmark_suite.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/monitoring_manager.h>
+#include <hl_monitoring/replay_image_provider.h>
+
+#include <algorithm>
+#include <random>
+
+namespace hl_monitoring
+{
+void runReplayBenchmarks(BenchmarkSuite* suite, const std::string& video_path, const std::string& meta_path,
+                         int nb_providers)
+{
+  ReplayImageProvider provider(video_path, meta_path);
+  const VideoMetaInformation& meta_information = provider.getMetaInformation();
+  int nb_frames = meta_information.frames_size();
+  if (nb_frames == 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "no frames in '" + meta_path + "'");
+  }
+  uint64_t start = provider.getStart();
+  uint64_t end = provider.getEnd();
+  std::mt19937 engine(42);
+
+  int nb_decoded = std::min(nb_frames, 100);
+  suite->run("replay/sequential_decode", nb_decoded, [&]() {
+    provider.restartStream();
+    for (int idx = 0; idx < nb_decoded; idx++)
+    {
+      cv::Mat img = provider.getNextImg();
+      doNotOptimize(img.data);
+    }
+  });
+
+  const size_t nb_seeks = 10;
+  std::uniform_int_distribution<int> frame_distrib(0, nb_frames - 1);
+  suite->run("replay/random_seek", nb_seeks, [&]() {
+    for (size_t idx = 0; idx < nb_seeks; idx++)
+    {
+      CalibratedImage calibrated_img =
+          provider.getCalibratedImage(meta_information.frames(frame_distrib(engine)).time_stamp());
+      doNotOptimize(calibrated_img.getImg().data);
+    }
+  });
+
+  // Sequential playback filling the same output: no allocations expected
+  CalibratedImage reused_img;
+  int playback_idx = 0;
+  suite->run("replay/get_calibrated_image_reused", 1, [&]() {
+    provider.getCalibratedImage(meta_information.frames(playback_idx).time_stamp(), &reused_img);
+    doNotOptimize(reused_img.getImg().data);
+    playback_idx = (playback_idx + 1) % nb_decoded;
+  });
+
+  const size_t nb_lookups = 10000;
+  std::uniform_int_distribution<uint64_t> ts_distrib(start, end);
+  std::vector<uint64_t> random_time_stamps(nb_lookups), sorted_time_stamps;
+  for (size_t idx = 0; idx < nb_lookups; idx++)
+  {
+    random_time_stamps[idx] = ts_distrib(engine);
+  }
+  sorted_time_stamps = random_time_stamps;
+  std::sort(sorted_time_stamps.begin(), sorted_time_stamps.end());
+  suite->run("replay/get_index_random", nb_lookups, [&]() {
+    int sum = 0;
+    for (uint64_t time_stamp : random_time_stamps)
+    {
+      sum += provider.getIndex(time_stamp);
+    }
+    doNotOptimize(sum);
+  });
+  suite->run("replay/get_index_monotonic", nb_lookups, [&]() {
+    int sum = 0;
+    for (uint64_t time_stamp : sorted_time_stamps)
+    {
+      sum += provider.getIndex(time_stamp);
+    }
+    doNotOptimize(sum);
+  });
+
+  std::string manager_name = "monitoring_manager/get_calibrated_images/providers_" + std::to_string(nb_providers);
+  std::string reused_name = "monitoring_manager/get_calibrated_images_reused/providers_" + std::to_string(nb_providers);
+  if (!suite->isEnabled(manager_name) && !suite->isEnabled(reused_name))
+  {
+    return;
+  }
+  // Simulates a playback: each iteration fetches the next frame of every provider
+  MonitoringManager manager;
+  for (int idx = 0; idx < nb_providers; idx++)
+  {
+    std::unique_ptr<ImageProvider> replay_provider(new ReplayImageProvider(video_path, meta_path));
+    manager.addImageProvider("camera_" + std::to_string(idx), std::move(replay_provider));
+  }
+  int frame_idx = 0;
+  suite->run(manager_name, nb_providers, [&]() {
+    uint64_t time_stamp = meta_information.frames(frame_idx).time_stamp();
+    std::map<std::string, CalibratedImage> images = manager.getCalibratedImages(time_stamp);
+    doNotOptimize(images);
+    frame_idx = (frame_idx + 1) % nb_decoded;
+  });
+  std::map<std::string, CalibratedImage> reused_images;
+  suite->run(reused_name, nb_providers, [&]() {
+    uint64_t time_stamp = meta_information.frames(frame_idx).time_stamp();
+    manager.getCalibratedImages(time_stamp, &reused_images);
+    doNotOptimize(reused_images);
+    frame_idx = (frame_idx + 1) % nb_decoded;
+  });
+}
+
+}  // namespace hl_monitoring
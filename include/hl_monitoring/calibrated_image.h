@@ -1,13 +1,17 @@
 #pragma once
 
-#include "hl_monitoring/camera.pb.h"
+#include "hl_monitoring/camera_model.h"
 
 #include <opencv2/core.hpp>
 
+#include <memory>
+
 namespace hl_monitoring
 {
 /**
  * Represents an image along with its intrinsic and extrinsic parameters
+ *
+ * The camera model is shared with all the images using the same parameters
  */
 class CalibratedImage
 {
@@ -15,14 +19,40 @@ public:
   CalibratedImage();
   CalibratedImage(const cv::Mat& img, const Pose3D& pose, const IntrinsicParameters& camera_parameters);
   CalibratedImage(const cv::Mat& img, const CameraMetaInformation& camera_meta);
+  CalibratedImage(const cv::Mat& img, const std::shared_ptr<const CameraModel>& camera_model);
+
+  /**
+   * Copies and moves share the image data and the camera model, none of them
+   * allocates memory
+   */
+  CalibratedImage(const CalibratedImage& other) = default;
+  CalibratedImage(CalibratedImage&& other) = default;
+  CalibratedImage& operator=(const CalibratedImage& other) = default;
+  CalibratedImage& operator=(CalibratedImage&& other) = default;
 
   const cv::Mat& getImg() const;
 
+  /**
+   * Release the image and the camera model, allowing their owners to reuse
+   * them in place
+   */
+  void clear();
+
   const CameraMetaInformation& getCameraInformation() const;
 
+  /**
+   * Throws a std::logic_error if the image has no camera model
+   */
+  const CameraModel& getCameraModel() const;
+  const std::shared_ptr<const CameraModel>& getSharedCameraModel() const;
+
   bool hasCameraParameters() const;
   bool hasPose() const;
 
+  /**
+   * Copy the parameters of the camera model in the given matrices, existing
+   * buffers are reused when possible
+   */
   void exportCameraParameters(cv::Mat* camera_matrix, cv::Mat* distortion_coefficients, cv::Size* size) const;
   void exportPose(cv::Mat* rvec, cv::Mat* tvec) const;
 
@@ -34,7 +64,7 @@ public:
 private:
   cv::Mat img;
 
-  CameraMetaInformation camera_meta;
+  std::shared_ptr<const CameraModel> camera_model;
 };
 
 }  // namespace hl_monitoring
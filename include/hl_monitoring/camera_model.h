@@ -0,0 +1,198 @@
+#pragma once
+
+#include "hl_monitoring/camera.pb.h"
+#include "hl_monitoring/projection_kernel.h"
+
+#include <opencv2/core.hpp>
+
+namespace hl_monitoring
+{
+/**
+ * Immutable representation of a camera using OpenCV formalism, built once from
+ * intrinsic and extrinsic parameters and then shared among all the frames
+ * using the same parameters.
+ *
+ * Intrinsic parameters and pose are both optional, accessors to a missing
+ * element throw a std::logic_error.
+ *
+ * Once shared, a model is never modified: setPose is only meant for owners of
+ * a model which is not referenced anymore by any image.
+ */
+class CameraModel
+{
+public:
+  CameraModel(const CameraMetaInformation& camera_meta);
+
+  const CameraMetaInformation& getCameraInformation() const;
+
+  /**
+   * Replace the pose of the camera, buffers of the model are reused and no
+   * memory is allocated once the model has a pose.
+   */
+  void setPose(const Pose3D& pose);
+
+  bool hasCameraParameters() const;
+  bool hasPose() const;
+
+  /**
+   * Return true if both pose and camera_parameters are specified
+   */
+  bool isFullySpecified() const;
+
+  /**
+   * Return true if the model has been built from the given parameters, nullptr
+   * stands for missing parameters.
+   */
+  bool matches(const IntrinsicParameters* camera_parameters, const Pose3D* pose) const;
+
+  const cv::Mat& getCameraMatrix() const;
+  const cv::Mat& getDistortionCoefficients() const;
+  const cv::Size& getImgSize() const;
+
+  /**
+   * Rodrigues rotation vector and translation from field basis to camera basis
+   */
+  const cv::Mat& getRVec() const;
+  const cv::Mat& getTVec() const;
+
+  /**
+   * Rotation matrix from field basis to camera basis
+   */
+  const cv::Matx33d& getRotation() const;
+
+  /**
+   * Rotation matrix from camera basis to field basis
+   */
+  const cv::Matx33d& getInverseRotation() const;
+
+  /**
+   * Position of the optical center of the camera in field basis
+   */
+  const cv::Vec3d& getCameraPosition() const;
+
+  /**
+   * Return the position of the given point in the image
+   */
+  cv::Point2f fieldToImg(const cv::Point3f& pos_in_field) const;
+
+  /**
+   * Project 'nb_points' points from the field basis to the image in a single
+   * pass, results are written in the buffers provided by the caller which must
+   * contain at least 'nb_points' elements.
+   *
+   * Models with up to 8 distortion coefficients use the specialized projection
+   * kernel, cv::projectPoints is used otherwise.
+   *
+   * If visible is not nullptr, visible[i] is set to 1 if the point is in front
+   * of the camera and inside the image, 0 otherwise.
+   */
+  void fieldToImg(const cv::Point3f* pos_in_field, size_t nb_points, cv::Point2f* pos_in_img,
+                  uint8_t* visible = nullptr) const;
+
+  /**
+   * Project all the positions, output vectors are resized if required, visible
+   * can be nullptr
+   */
+  void fieldToImg(const std::vector<cv::Point3f>& pos_in_field, std::vector<cv::Point2f>* pos_in_img,
+                  std::vector<uint8_t>* visible = nullptr) const;
+
+  /**
+   * Return true if the point is in front of the camera
+   */
+  bool isInFront(const cv::Point3f& pos_in_field) const;
+
+  /**
+   * Convert points from image to normalized camera coordinates (z=1) by
+   * iteratively inverting the distortion model.
+   */
+  void undistortPoints(const cv::Point2f* pos_in_img, size_t nb_points, cv::Point2f* normalized) const;
+
+  /**
+   * Compute the intersection of the ray going through 'pos_in_img' with the
+   * horizontal plane z = height. Returns false if the plane is not in front of
+   * the camera along the ray.
+   */
+  bool imgToField(const cv::Point2f& pos_in_img, cv::Point3f* pos_in_field, double height = 0) const;
+
+  /**
+   * Batch version of imgToField: buffers provided by the caller must contain at
+   * least 'nb_points' elements. valid[i] is set to 1 if the intersection exists
+   * and 0 otherwise, valid can be nullptr. Intermediate results are kept on the
+   * stack, no memory is allocated for models with up to 8 distortion
+   * coefficients.
+   */
+  void imgToField(const cv::Point2f* pos_in_img, size_t nb_points, cv::Point3f* pos_in_field,
+                  uint8_t* valid = nullptr, double height = 0) const;
+
+  /**
+   * Batch version of imgToField for vectors, outputs are resized if required
+   */
+  void imgToField(const std::vector<cv::Point2f>& pos_in_img, std::vector<cv::Point3f>* pos_in_field,
+                  std::vector<uint8_t>* valid = nullptr, double height = 0) const;
+
+  /**
+   * Homography from the ground plane (x,y,1) in field basis to the image
+   * without distortion: K [r1 r2 t]
+   */
+  const cv::Matx33d& getGroundHomography() const;
+
+private:
+  void checkCameraParameters() const;
+  void checkPose() const;
+
+  /**
+   * Update all the members depending on the pose of camera_meta
+   */
+  void updatePose();
+
+  /**
+   * Return the homography from normalized camera coordinates to the plane
+   * z = height in field basis: [r1 r2 r3*height+t]^-1
+   */
+  cv::Matx33d getNormalizedToPlane(double height) const;
+
+  /**
+   * Maximal number of distortion coefficients handled by undistortPoints
+   * without OpenCV (k1,k2,p1,p2,k3,k4,k5,k6)
+   */
+  static constexpr int max_fast_distortion_size = 8;
+
+  CameraMetaInformation camera_meta;
+
+  cv::Mat camera_matrix;
+  cv::Mat distortion_coefficients;
+  cv::Size img_size;
+
+  cv::Mat rvec;
+  cv::Mat tvec;
+  cv::Matx33d rotation;
+  cv::Matx33d inverse_rotation;
+  cv::Vec3d camera_position;
+
+  /**
+   * Distortion coefficients padded with zeros
+   */
+  double distortion[max_fast_distortion_size];
+
+  /**
+   * Parameters of the projection kernel, only valid if use_projection_kernel is true
+   */
+  ProjectionParameters projection_parameters;
+  DistortionModel distortion_model;
+  bool use_projection_kernel;
+
+  cv::Matx33d ground_homography;
+
+  /**
+   * Homography from normalized camera coordinates to ground plane
+   */
+  cv::Matx33d normalized_to_ground;
+};
+
+/**
+ * Return true if both parameters are identical, nullptr stands for missing parameters
+ */
+bool isSameIntrinsic(const IntrinsicParameters* p1, const IntrinsicParameters* p2);
+bool isSamePose(const Pose3D* p1, const Pose3D* p2);
+
+}  // namespace hl_monitoring
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace hl_monitoring
+{
+/**
+ * Estimates the relation between two clocks from pairs of simultaneous
+ * readings: target = reference + offset + drift * (reference - reference_0).
+ *
+ * Only the most recent samples are used. Drift is the median of the slopes
+ * between samples half a window apart and offset is the median of the
+ * residuals, so that readings delayed by preemption or by the transport of a
+ * hardware time_stamp have a limited impact on the estimation.
+ *
+ * All time_stamps are in microseconds.
+ */
+class ClockSynchronizer
+{
+public:
+  /**
+   * max_samples: number of samples kept for the estimation
+   */
+  ClockSynchronizer(size_t max_samples = 200);
+
+  /**
+   * Add a pair of readings of the reference clock and the target clock
+   */
+  void addSample(int64_t reference, int64_t target);
+
+  /**
+   * Read steady_clock (reference) and system_clock (target) and add the sample.
+   * System clock is read between two readings of the steady clock, the reading
+   * with the lowest latency among a few attempts is used.
+   */
+  void sampleSystemClock();
+
+  bool hasEstimate() const;
+
+  size_t getNbSamples() const;
+
+  /**
+   * Estimated offset between target and reference at the given reference
+   * time_stamp. Throws a std::logic_error if there are no samples.
+   */
+  int64_t getOffset(int64_t reference) const;
+
+  /**
+   * Estimated offset at the time of the last sample
+   */
+  int64_t getOffset() const;
+
+  /**
+   * Drift of the target clock relative to the reference clock [us/us]
+   */
+  double getDrift() const;
+
+  /**
+   * Standard error of the offset estimation [us], based on the median absolute
+   * deviation of the residuals
+   */
+  double getUncertainty() const;
+
+  void clear();
+
+private:
+  struct Sample
+  {
+    int64_t reference;
+    int64_t target;
+  };
+
+  void updateEstimate();
+
+  size_t max_samples;
+
+  std::deque<Sample> samples;
+
+  /**
+   * Estimation is expressed relatively to the first sample of the window to
+   * preserve precision: offset(t) = base_offset + intercept + drift * (t - base_reference)
+   */
+  int64_t base_reference;
+  int64_t base_offset;
+  double intercept;
+  double drift;
+  double uncertainty;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <json/json.h>
+#include <opencv2/videoio.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Describes how recorded videos are encoded: codec, container, quality and
+ * number of threads.
+ *
+ * The following presets are available:
+ * - legacy: XVID in an avi container, historical behavior
+ * - fast_lossless: FFV1 in a mkv container, multithreaded with slices
+ * - cheap_intra: MJPEG in an avi container, encoded by the built-in encoder of
+ *   OpenCV in parallel stripes
+ * - compact: H.264 in a mp4 container with a long GOP
+ *
+ * Codecs are encoded with FFmpeg except for the 'opencv_mjpeg' backend. Threads,
+ * GOP, quality and custom options are forwarded to FFmpeg through the
+ * OPENCV_FFMPEG_WRITER_OPTIONS environment variable, which is only read by
+ * OpenCV 4.6 and later: with older versions, opening a writer with settings
+ * that cannot be applied throws instead of silently ignoring them.
+ *
+ * In json, settings can either be the name of a preset or an object with an
+ * optional 'preset' member whose values are overriden by the other members.
+ */
+class EncoderSettings
+{
+public:
+  /**
+   * Legacy preset
+   */
+  EncoderSettings();
+
+  /**
+   * Throws a std::out_of_range if no preset has the given name
+   */
+  static EncoderSettings getPreset(const std::string& name);
+  static std::vector<std::string> getPresetNames();
+
+  Json::Value toJson() const;
+  void fromJson(const Json::Value& v);
+
+  /**
+   * Return the path of the video with the given prefix, extension depends on
+   * the container
+   */
+  std::string getPath(const std::string& prefix) const;
+
+  /**
+   * Open the writer at the given path with the settings, throws a
+   * std::runtime_error on failure or if some settings cannot be applied with
+   * the backend and the version of OpenCV
+   */
+  void open(const std::string& path, double fps, const cv::Size& img_size, bool use_color,
+            cv::VideoWriter* writer) const;
+
+  /**
+   * Return the options transmitted to FFmpeg, e.g. 'threads;4|g;60'. Settings
+   * left to their default value (e.g. threads at 0) are not included.
+   */
+  std::string getFFmpegOptions() const;
+
+  /**
+   * Return true if the settings require options for FFmpeg: number of threads,
+   * GOP, constant rate factor or custom options
+   */
+  bool requiresFFmpegOptions() const;
+
+  /**
+   * Four characters code of the codec, e.g. 'FFV1', 'MJPG', 'avc1'
+   */
+  std::string codec;
+
+  /**
+   * Extension of the video file: 'avi', 'mkv', 'mp4'...
+   */
+  std::string container;
+
+  /**
+   * 'ffmpeg', 'opencv_mjpeg' or 'any' (let OpenCV choose)
+   */
+  std::string backend;
+
+  /**
+   * Quality in [0,100], -1 for the default of the codec. Used as JPEG quality
+   * for MJPEG and converted to a constant rate factor for H.264
+   */
+  int quality;
+
+  /**
+   * Number of threads used for encoding, 0 for automatic
+   */
+  int threads;
+
+  /**
+   * Maximal distance between two key frames, -1 for the default of the codec
+   */
+  int gop;
+
+  /**
+   * Additional FFmpeg options with format 'key1;value1|key2;value2'
+   */
+  std::string options;
+};
+
+/**
+ * OpenCV reads the options of FFmpeg from the environment when opening
+ * captures and writers while EncoderSettings::open modifies it: all the
+ * captures and writers of the process have to be opened while holding this
+ * lock, including those of providers built in parallel.
+ */
+std::unique_lock<std::mutex> lockVideoEnvironment();
+
+}  // namespace hl_monitoring
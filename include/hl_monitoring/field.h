@@ -1,6 +1,6 @@
 #pragma once
 
-#include <hl_monitoring/camera.pb.h>
+#include <hl_monitoring/camera_model.h>
 
 #include <opencv2/core.hpp>
 #include <json/json.h>
@@ -71,11 +71,21 @@ public:
   const std::vector<cv::Point3f>& getGoalPosts() const;
   const std::vector<cv::Point3f>& getPenaltyMarks() const;
 
+  /**
+   * Draw the white lines of the field on tag_img. Lines are clipped against the
+   * near plane of the camera and against the image borders.
+   *
+   * With a distorted camera, lines are split in segments depending on their
+   * length in the image, nb_segments is the minimal number of segments per line.
+   * All points are projected in a single pass.
+   */
   void tagLines(const CameraMetaInformation& camera_information, cv::Mat* tag_img, const cv::Scalar& line_color,
-                double line_thickness, int nb_segments = 1);
+                double line_thickness, int nb_segments = 1) const;
+  void tagLines(const CameraModel& camera_model, cv::Mat* tag_img, const cv::Scalar& line_color,
+                double line_thickness, int nb_segments = 1) const;
   void tagLines(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
                 const cv::Mat& tvec, cv::Mat* tag_img, const cv::Scalar& line_color, double line_thickness,
-                int nb_segments = 1);
+                int nb_segments = 1) const;
 
   double getArenaLength() const;
   double getArenaWidth() const;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "hl_monitoring/field.h"
+
+#include <map>
+#include <memory>
+
+namespace hl_monitoring
+{
+/**
+ * Caches the rendering of the field lines for multiple cameras.
+ *
+ * For each camera, lines are rendered once in a mask which is then applied on
+ * every frame. The mask is rebuilt only when the camera model (intrinsic or
+ * pose), the field or the style of the lines change.
+ */
+class FieldOverlayCache
+{
+public:
+  FieldOverlayCache();
+
+  /**
+   * Draw the white lines of the field on img, see Field::tagLines
+   */
+  void tagLines(const std::string& camera_name, const Field& field,
+                const std::shared_ptr<const CameraModel>& camera_model, cv::Mat* img, const cv::Scalar& line_color,
+                double line_thickness, int nb_segments = 1);
+
+  /**
+   * Remove all cached overlays
+   */
+  void clear();
+
+private:
+  struct Overlay
+  {
+    /**
+     * Model used to build the overlay
+     */
+    std::shared_ptr<const CameraModel> camera_model;
+
+    /**
+     * Lines of the field used to build the overlay
+     */
+    std::vector<Field::Segment> white_lines;
+
+    double line_thickness;
+    int nb_segments;
+
+    /**
+     * Non-zero for pixels belonging to the lines
+     */
+    cv::Mat mask;
+  };
+
+  /**
+   * Return true if the overlay has been built with the given parameters
+   */
+  static bool isUpToDate(const Overlay& overlay, const Field& field,
+                         const std::shared_ptr<const CameraModel>& camera_model, double line_thickness,
+                         int nb_segments);
+
+  std::map<std::string, Overlay> overlays;
+};
+
+}  // namespace hl_monitoring
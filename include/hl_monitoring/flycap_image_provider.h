@@ -1,6 +1,8 @@
 #pragma once
 
+#include "hl_monitoring/encoder_settings.h"
 #include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/replay_buffer.h"
 
 #include <json/json.h>
 #include <flycapture/FlyCapture2.h>
@@ -28,9 +30,11 @@ class FlyCapImageProvider : public ImageProvider
 public:
   /**
    * If output_prefix is not empty, write video during execution and saves
-   * MetaInformation when object is closed
+   * MetaInformation when object is closed. The video is encoded with the
+   * provided settings.
    */
-  FlyCapImageProvider(const Json::Value& v, const std::string& output_prefix = "");
+  FlyCapImageProvider(const Json::Value& v, const std::string& output_prefix = "",
+                      const EncoderSettings& encoder_settings = EncoderSettings());
   virtual ~FlyCapImageProvider();
 
   /**
@@ -43,8 +47,30 @@ public:
 
   void restartStream() override;
 
+  /**
+   * Keep the last 'duration' seconds of the stream compressed in memory, allowing
+   * to retrieve past frames with getCalibratedImage
+   */
+  void enableReplayBuffer(double duration, int jpeg_quality = 85);
+
+  /**
+   * Return nullptr if the replay buffer is not enabled
+   */
+  const ReplayBuffer* getReplayBuffer() const;
+
+  using ImageProvider::getCalibratedImage;
+  /**
+   * Frames older than the last one are only available if the replay buffer is
+   * enabled, an empty image is returned for frames which already left its window
+   */
   CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
 
+  /**
+   * Return the time_stamp of the oldest frame which can still be retrieved:
+   * start of the replay buffer if enabled, last frame received otherwise
+   */
+  uint64_t getStart() const override;
+
   void update() override;
 
   cv::Mat getNextImg() override;
@@ -133,6 +159,16 @@ private:
    * then no files are written
    */
   std::string output_prefix;
+
+  /**
+   * Codec and parameters used to encode the output video
+   */
+  EncoderSettings encoder_settings;
+
+  /**
+   * Last frames of the stream, nullptr if not enabled
+   */
+  std::unique_ptr<ReplayBuffer> replay_buffer;
 };
 
 }  // namespace hl_monitoring
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "hl_monitoring/camera.pb.h"
+
+#include <string>
+
+namespace hl_monitoring
+{
+/**
+ * A frame index is a binary sidecar of a serialized VideoMetaInformation
+ * allowing to access frames by time_stamp without parsing the frame entries.
+ * It is stored next to the meta information with the '.idx' extension appended
+ * and memory-mapped on opening.
+ *
+ * Layout of the file:
+ * - FrameIndexHeader
+ * - The serialized VideoMetaInformation without frames (header_size bytes),
+ *   padded to a multiple of 8 bytes
+ * - nb_frames FrameIndexRecord sorted by time_stamp
+ * - nb_poses FrameIndexPose in the order of the frames
+ *
+ * Size and modification time of the meta information are stored in the header,
+ * an index which does not match its meta information is rebuilt.
+ */
+struct FrameIndexHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t nb_frames;
+  uint64_t nb_poses;
+  /**
+   * Size [bytes] and modification time [ns] of the meta information indexed
+   */
+  uint64_t meta_size;
+  int64_t meta_mtime;
+  uint32_t header_size;
+  uint32_t reserved;
+};
+
+struct FrameIndexRecord
+{
+  uint64_t time_stamp;
+  /**
+   * Index of the frame in the video
+   */
+  uint32_t frame_number;
+  uint32_t flags;
+  /**
+   * Offset of the FrameIndexPose from the beginning of the index, only valid
+   * if flags contains frame_index_has_pose
+   */
+  uint64_t pose_offset;
+};
+
+struct FrameIndexPose
+{
+  float rotation[3];
+  float translation[3];
+};
+
+constexpr uint32_t frame_index_magic = 0x484c4649;  // 'HLFI'
+constexpr uint32_t frame_index_version = 1;
+constexpr uint32_t frame_index_has_pose = 1;
+
+/**
+ * Read-only access to the frame index of a meta information file.
+ *
+ * The index is generated on the first opening of a meta information file, if
+ * it cannot be written next to the meta information, it is kept in memory.
+ * Lookups are binary searches on the records, opening a recording does not
+ * depend on its length once the index exists.
+ */
+class FrameIndex
+{
+public:
+  FrameIndex();
+  ~FrameIndex();
+
+  FrameIndex(const FrameIndex& other) = delete;
+  FrameIndex& operator=(const FrameIndex& other) = delete;
+
+  /**
+   * Return the path of the index associated to the given meta information
+   */
+  static std::string getIndexPath(const std::string& meta_path);
+
+  /**
+   * Build the content of the index of the given meta information.
+   * Throws a std::runtime_error if the meta information is invalid, if two
+   * frames share the same time_stamp or if a pose is not a Rodrigues vector
+   * with a 3d translation.
+   */
+  static std::string build(const std::string& meta_path);
+
+  /**
+   * Open the index of the meta information, building and writing it if it does
+   * not exist or if it is outdated
+   */
+  void open(const std::string& meta_path);
+
+  void close();
+
+  bool isOpen() const;
+
+  /**
+   * Return the content of the meta information without frames
+   */
+  const VideoMetaInformation& getHeader() const;
+
+  size_t size() const;
+
+  /**
+   * Records are sorted by time_stamp
+   */
+  const FrameIndexRecord& getRecord(size_t idx) const;
+
+  /**
+   * Return the index of the last record with a time_stamp lower or equal to
+   * time_stamp, -1 if there is no such record
+   */
+  int find(uint64_t time_stamp) const;
+
+  /**
+   * Return false if the record has no pose, otherwise fill pose
+   */
+  bool getPose(const FrameIndexRecord& record, Pose3D* pose) const;
+
+  /**
+   * time_stamps of the first and the last records, 0 if index is empty
+   */
+  uint64_t getStart() const;
+  uint64_t getEnd() const;
+
+private:
+  /**
+   * Map the index at the given path, returns false if it cannot be opened or
+   * if it does not match the given size and modification time of the meta
+   * information
+   */
+  bool map(const std::string& index_path, uint64_t meta_size, int64_t meta_mtime);
+
+  /**
+   * Use the content as index, returns false if it is not consistent
+   */
+  bool setContent(const uint8_t* data, size_t data_size);
+
+  /**
+   * Start and size of the mapping, nullptr if index is stored in memory
+   */
+  uint8_t* mapping;
+  size_t mapping_size;
+
+  /**
+   * Content of the index if it could not be written
+   */
+  std::string memory;
+
+  const FrameIndexHeader* header;
+  const FrameIndexRecord* records;
+  size_t content_size;
+
+  VideoMetaInformation meta_header;
+};
+
+}  // namespace hl_monitoring
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "hl_monitoring/calibrated_image.h"
+#include "hl_monitoring/pose_timeline.h"
 
 namespace hl_monitoring
 {
@@ -30,6 +31,19 @@ public:
    */
   CalibratedImage getCalibratedImage(uint64_t time_stamp, bool system_clock);
 
+  /**
+   * Fill 'out' with the image at the given time_stamp (steady_clock). Reusing
+   * the same output allows providers to fetch images without allocating once
+   * their buffers and camera models are initialized.
+   */
+  virtual void getCalibratedImage(uint64_t time_stamp, CalibratedImage* out);
+
+  /**
+   * Return the time_stamp (steady_clock) of the frame returned by
+   * getCalibratedImage for the given time_stamp, 0 if there is no such frame
+   */
+  virtual uint64_t getFrameTimeStamp(uint64_t time_stamp) const;
+
   /**
    * For livestream, receive images from the stream
    */
@@ -63,9 +77,21 @@ public:
    */
   virtual size_t getNbFrames() const;
 
+  /**
+   * Return the meta information of the stream: header and frame entries
+   */
+  virtual const VideoMetaInformation& getMetaInformation();
+
   virtual void setIntrinsic(const IntrinsicParameters& params);
   virtual void setDefaultPose(const Pose3D& pose);
 
+  /**
+   * Add a sample to the pose timeline of the camera, frames without pose use
+   * the pose interpolated from the timeline at their time_stamp (steady_clock).
+   * This allows pose estimators to run at a lower rate than the camera.
+   */
+  void addPoseSample(uint64_t time_stamp, const Pose3D& pose);
+
   /**
    * Set the offset in us between steady_clock and system_clock (time_since_epoch)
    */
@@ -77,6 +103,22 @@ public:
   int64_t getOffset() const;
 
 protected:
+  /**
+   * Return the camera model for the given frame, using by order of priority:
+   * the pose of the frame, the pose interpolated from the pose timeline and the
+   * default pose. If frame is nullptr, the default pose is used.
+   *
+   * Models are cached and rebuilt only when the parameters change. If only the
+   * pose changed and no image uses the cached model anymore, the model is
+   * updated in place instead of being rebuilt.
+   */
+  std::shared_ptr<const CameraModel> getCameraModel(const FrameEntry* frame);
+
+  /**
+   * Rebuild the pose timeline from the poses of all the frames of meta_information
+   */
+  void updatePoseTimeline();
+
   /**
    * Information relevant to the video stream
    */
@@ -96,6 +138,27 @@ protected:
    * The number of frames in the video
    */
   int nb_frames;
+
+private:
+  /**
+   * Poses of the camera through time
+   */
+  PoseTimeline pose_timeline;
+
+  /**
+   * Buffer for the poses interpolated from the timeline
+   */
+  Pose3D interpolated_pose;
+
+  /**
+   * Last camera model built with the default pose
+   */
+  std::shared_ptr<CameraModel> default_camera_model;
+
+  /**
+   * Last camera model built with the pose of a frame
+   */
+  std::shared_ptr<CameraModel> frame_camera_model;
 };
 
 }  // namespace hl_monitoring
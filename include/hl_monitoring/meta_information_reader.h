@@ -0,0 +1,86 @@
+#pragma once
+
+#include "hl_monitoring/camera.pb.h"
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+
+#include <memory>
+
+namespace hl_monitoring
+{
+/**
+ * Provides access to a serialized VideoMetaInformation without parsing all the
+ * FrameEntry it contains.
+ *
+ * On opening, the file is scanned once: frame entries are skipped based on
+ * their length prefix, only the first and the last ones are parsed. All the
+ * other fields are stored in a 'header' which is a VideoMetaInformation
+ * without any frame.
+ *
+ * Frames can then be read one after the other using readNextFrame
+ */
+class MetaInformationReader
+{
+public:
+  /**
+   * Throws a std::runtime_error if the file cannot be opened or is not a valid
+   * VideoMetaInformation
+   */
+  MetaInformationReader(const std::string& path);
+  ~MetaInformationReader();
+
+  const std::string& getPath() const;
+
+  /**
+   * Returns all the content of the file except the frame entries
+   */
+  const VideoMetaInformation& getHeader() const;
+
+  int getNbFrames() const;
+
+  /**
+   * Throws a std::out_of_range if there are no frames in the file
+   */
+  const FrameEntry& getFirstFrame() const;
+  const FrameEntry& getLastFrame() const;
+
+  /**
+   * Move the reading cursor back to the beginning of the file
+   */
+  void restart();
+
+  /**
+   * Read the next frame entry of the file and place it in 'frame'.
+   * Returns false if there are no more frames to read.
+   */
+  bool readNextFrame(FrameEntry* frame);
+
+private:
+  /**
+   * Open a new input stream starting at the given offset in the file
+   */
+  void openStream(int64_t offset);
+
+  /**
+   * Go through the whole file, filling header, first_frame, last_frame and nb_frames
+   */
+  void scan();
+
+  std::string path;
+
+  /**
+   * File descriptor of the file opened
+   */
+  int fd;
+
+  std::unique_ptr<google::protobuf::io::FileInputStream> input;
+
+  VideoMetaInformation header;
+
+  FrameEntry first_frame;
+  FrameEntry last_frame;
+
+  int nb_frames;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "hl_monitoring/camera.pb.h"
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+
+#include <memory>
+
+namespace hl_monitoring
+{
+/**
+ * Writes a serialized VideoMetaInformation incrementally: frame entries are
+ * appended one after the other without keeping them in memory.
+ *
+ * Since protobuf merges fields on parsing, header and frames can be written in
+ * any order, but writing the header first allows MetaInformationReader to
+ * reach it without scanning all the frames.
+ */
+class MetaInformationWriter
+{
+public:
+  /**
+   * Throws a std::runtime_error if the file cannot be opened
+   */
+  MetaInformationWriter(const std::string& path);
+  ~MetaInformationWriter();
+
+  const std::string& getPath() const;
+
+  /**
+   * Write all the content of header, including its frame entries if there are any
+   */
+  void writeHeader(const VideoMetaInformation& header);
+
+  void writeFrame(const FrameEntry& frame);
+
+  /**
+   * Number of frames written with writeFrame
+   */
+  int getNbFrames() const;
+
+  /**
+   * Flush the content and close the file, throws a std::runtime_error on failure
+   */
+  void close();
+
+private:
+  void checkOpen() const;
+
+  std::string path;
+
+  std::unique_ptr<google::protobuf::io::FileOutputStream> output;
+
+  int nb_frames;
+};
+
+}  // namespace hl_monitoring
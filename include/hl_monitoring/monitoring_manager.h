@@ -1,6 +1,8 @@
 #pragma once
 
+#include <hl_monitoring/clock_synchronizer.h>
 #include <hl_monitoring/image_provider.h>
+#include <hl_monitoring/status_cursor.h>
 #include <hl_communication/message_manager.h>
 
 #include <json/json.h>
@@ -36,7 +38,22 @@ public:
 
   std::map<std::string, CalibratedImage> getCalibratedImages(uint64_t time_stamp);
 
-  hl_communication::MessageManager::Status getStatus(uint64_t time_stamp);
+  /**
+   * Fill 'images' with the images of all the providers which started before
+   * time_stamp, providers which cannot provide an image for time_stamp have no
+   * entry. Entries of the map are reused: when called repeatedly with the same
+   * map, no memory is allocated once all the providers have started.
+   */
+  void getCalibratedImages(uint64_t time_stamp, std::map<std::string, CalibratedImage>* images);
+
+  /**
+   * Return the status of the game at the given time_stamp. For monotonic
+   * requests, only the messages received since the last request are applied to
+   * the status (see StatusCursor).
+   *
+   * The reference is valid until the next call to getStatus
+   */
+  const hl_communication::MessageManager::Status& getStatus(uint64_t time_stamp);
 
   /**
    * Returns non-mutable access to the given image provider if it exists.
@@ -72,12 +89,34 @@ public:
    */
   int64_t getOffset() const;
 
+  /**
+   * Estimation of the relation between steady_clock and system_clock, updated
+   * continuously by update() for live sessions
+   */
+  const ClockSynchronizer& getClockSynchronizer() const;
+
+  /**
+   * Uncertainty on the offset between steady_clock and system_clock [us]
+   */
+  double getOffsetUncertainty() const;
+
 private:
+  /**
+   * Sample the clocks if required and push the estimated offset to the
+   * message_manager and the image providers
+   */
+  void updateClockSynchronization();
+
   /**
    * Access to message from both, robots and GameController
    */
   std::unique_ptr<hl_communication::MessageManager> message_manager;
 
+  /**
+   * Cache of the status provided by the message_manager
+   */
+  std::unique_ptr<StatusCursor> status_cursor;
+
   /**
    * Access to all the channels allowing to retrieve images
    */
@@ -93,6 +132,18 @@ private:
    * Is the monitoring session live or not?
    */
   bool live;
+
+  ClockSynchronizer clock_synchronizer;
+
+  /**
+   * Steady time_stamp of the last clock sample [us]
+   */
+  uint64_t last_clock_sample;
+
+  /**
+   * Minimal duration between two samples of the clocks [us]
+   */
+  uint64_t clock_sampling_period;
 };
 
 }  // namespace hl_monitoring
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "hl_monitoring/encoder_settings.h"
 #include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/replay_buffer.h"
 
 #include <opencv2/videoio.hpp>
 
@@ -16,9 +18,11 @@ class OpenCVImageProvider : public ImageProvider
 public:
   /**
    * If output_prefix is not empty, write video during execution and saves
-   * MetaInformation when object is closed
+   * MetaInformation when object is closed. The video is encoded with the
+   * provided settings.
    */
-  OpenCVImageProvider(const std::string& video_path, const std::string& output_prefix = "");
+  OpenCVImageProvider(const std::string& video_path, const std::string& output_prefix = "",
+                      const EncoderSettings& encoder_settings = EncoderSettings());
   virtual ~OpenCVImageProvider();
 
   double getFPS() const;
@@ -28,7 +32,35 @@ public:
 
   void restartStream() override;
 
+  /**
+   * Keep the last 'duration' seconds of the stream compressed in memory, allowing
+   * to retrieve past frames with getCalibratedImage
+   */
+  void enableReplayBuffer(double duration, int jpeg_quality = 85);
+
+  /**
+   * Return nullptr if the replay buffer is not enabled
+   */
+  const ReplayBuffer* getReplayBuffer() const;
+
+  using ImageProvider::getCalibratedImage;
+  /**
+   * Frames older than the last one are only available if the replay buffer is
+   * enabled, an empty image is returned for frames which already left its window
+   */
   CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
+  /**
+   * The most recent frame shares the buffer of the stream, past frames are
+   * decoded in the buffer of out when no other image uses it. Camera models are
+   * updated in place when possible.
+   */
+  void getCalibratedImage(uint64_t time_stamp, CalibratedImage* out) override;
+
+  /**
+   * Return the time_stamp of the oldest frame which can still be retrieved:
+   * start of the replay buffer if enabled, last frame received otherwise
+   */
+  uint64_t getStart() const override;
 
   void update() override;
 
@@ -64,6 +96,16 @@ private:
    * then no files are written
    */
   std::string output_prefix;
+
+  /**
+   * Codec and parameters used to encode the output video
+   */
+  EncoderSettings encoder_settings;
+
+  /**
+   * Last frames of the stream, nullptr if not enabled
+   */
+  std::unique_ptr<ReplayBuffer> replay_buffer;
 };
 
 }  // namespace hl_monitoring
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "hl_monitoring/camera.pb.h"
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Stores sparse samples of the pose of a camera and provides the pose at any
+ * time_stamp by interpolation: SLERP on rotation and linear interpolation on
+ * translation.
+ *
+ * Samples are stored in a compact form (time_stamp, quaternion, translation)
+ * sorted by time_stamp. A cursor on the last segment used makes lookups O(1)
+ * amortized when time_stamps are monotonic, other lookups use a binary search.
+ */
+class PoseTimeline
+{
+public:
+  PoseTimeline();
+
+  void clear();
+
+  /**
+   * Add a sample to the timeline, replacing the existing sample at the same
+   * time_stamp if there is one. Appending samples in chronological order is
+   * O(1), other insertions are O(n).
+   * Throws a std::runtime_error if the pose is not a Rodrigues rotation vector
+   * with a 3d translation.
+   */
+  void addSample(uint64_t time_stamp, const Pose3D& pose);
+
+  bool empty() const;
+  size_t size() const;
+
+  /**
+   * Return the time_stamp of the first and the last sample, 0 if there is no sample
+   */
+  uint64_t getStart() const;
+  uint64_t getEnd() const;
+
+  /**
+   * Write in pose the pose of the camera at the given time_stamp. Outside of
+   * the range of the samples, the closest sample is used. If the time_stamp
+   * matches a sample, its pose is returned without modification.
+   * Returns false if the timeline is empty.
+   */
+  bool getPose(uint64_t time_stamp, Pose3D* pose);
+
+private:
+  struct Sample
+  {
+    uint64_t time_stamp;
+    /**
+     * Rodrigues vector as provided by the user
+     */
+    cv::Vec3d rotation;
+    /**
+     * Unit quaternion (w,x,y,z) with w >= 0
+     */
+    cv::Vec4d quaternion;
+    cv::Vec3d translation;
+  };
+
+  /**
+   * Return the index of the last sample with a time_stamp lower or equal to
+   * time_stamp, the timeline should not be empty and time_stamp should be
+   * greater or equal to the first time_stamp.
+   */
+  size_t getSegment(uint64_t time_stamp);
+
+  static void exportSample(const Sample& sample, Pose3D* pose);
+
+  std::vector<Sample> samples;
+
+  /**
+   * Index of the last segment used
+   */
+  size_t cursor;
+};
+
+/**
+ * Conversions between Rodrigues vectors and unit quaternions (w,x,y,z)
+ */
+cv::Vec4d rodriguesToQuaternion(const cv::Vec3d& rvec);
+cv::Vec3d quaternionToRodrigues(const cv::Vec4d& q);
+
+/**
+ * Spherical linear interpolation between two unit quaternions, t in [0,1]
+ */
+cv::Vec4d slerp(const cv::Vec4d& q1, const cv::Vec4d& q2, double t);
+
+}  // namespace hl_monitoring
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "hl_monitoring/field.h"
+
+#include <memory>
+
+namespace hl_monitoring
+{
+/**
+ * Refines the pose of a camera at each frame by matching the white lines of
+ * the field with the white pixels of the image.
+ *
+ * Points are sampled regularly along the white lines of the field and
+ * projected with the current pose. For each visible point, the closest white
+ * pixel is searched along the normal of the projected line in a small window.
+ * The pose is then refined by solvePnP using the current pose as initial
+ * guess, the process being repeated for a few iterations.
+ *
+ * When the refinement fails (not enough matches or high reprojection error),
+ * the last good pose is kept.
+ */
+class PoseTracker
+{
+public:
+  /**
+   * sample_spacing: distance between two points sampled on the white lines [m]
+   * search_radius: maximal distance between a projected point and its match [px]
+   */
+  PoseTracker(const Field& field, double sample_spacing = 0.1, int search_radius = 10);
+
+  void setIntrinsic(const IntrinsicParameters& camera_parameters);
+
+  /**
+   * Set the pose used as initial guess for the next frame
+   */
+  void setPose(const Pose3D& pose);
+
+  bool hasPose() const;
+
+  /**
+   * Refine the pose using the given image and write the result in pose. If
+   * refinement fails, the last good pose is written.
+   * Returns true if the pose has been refined.
+   * Throws a std::logic_error if intrinsic parameters or initial pose are missing.
+   */
+  bool update(const cv::Mat& img, Pose3D* pose);
+
+  /**
+   * Refine the pose and store it in the pose of the frame
+   */
+  bool update(const cv::Mat& img, FrameEntry* frame);
+
+  /**
+   * Number of matches and reprojection error [px] of the last refinement
+   */
+  int getNbMatches() const;
+  double getError() const;
+
+  /**
+   * Return the white pixels detected in the last image
+   */
+  const cv::Mat& getWhiteMask() const;
+
+  /**
+   * Minimal number of matches required to accept a refinement
+   */
+  int min_matches;
+
+  /**
+   * Maximal root mean square reprojection error to accept a refinement [px]
+   */
+  double max_error;
+
+  /**
+   * Number of successive matching and optimization steps
+   */
+  int nb_iterations;
+
+  /**
+   * Minimal difference between a pixel and its neighborhood to be considered as white
+   */
+  int white_threshold;
+
+private:
+  /**
+   * Compute the mask of white pixels in white_mask: pixels brighter than the
+   * average of their neighborhood, neighborhood being larger than the lines
+   */
+  void updateWhiteMask(const cv::Mat& img);
+
+  /**
+   * Match the samples with white pixels using the pose described by rvec and
+   * tvec. Returns the number of matches.
+   */
+  int matchSamples(const cv::Mat& rvec, const cv::Mat& tvec);
+
+  /**
+   * Return the offset along the normal of the center of the white run closest
+   * to pos, returns false if no white pixel is found in the search window
+   */
+  bool searchAlongNormal(const cv::Point2f& pos, const cv::Point2f& normal, float* offset) const;
+
+  /**
+   * Return the model of the camera with the given pose
+   */
+  CameraModel getModel(const cv::Mat& rvec, const cv::Mat& tvec) const;
+
+  double sample_spacing;
+  int search_radius;
+
+  /**
+   * Intrinsic parameters and last good pose
+   */
+  CameraMetaInformation camera_meta;
+  bool has_pose;
+
+  cv::Mat camera_matrix;
+  cv::Mat distortion_coefficients;
+
+  /**
+   * Samples on the white lines and, for each sample, a close point along the
+   * same line used to compute the direction of the line in the image
+   */
+  std::vector<cv::Point3f> samples;
+  std::vector<cv::Point3f> sample_ends;
+
+  /**
+   * Buffers reused between frames
+   */
+  std::vector<cv::Point3f> projection_input;
+  std::vector<cv::Point2f> projection_output;
+  std::vector<uint8_t> projection_visible;
+  std::vector<cv::Point3f> matched_in_field;
+  std::vector<cv::Point2f> matched_in_img;
+  cv::Mat gray;
+  cv::Mat background;
+  cv::Mat white_mask;
+
+  int nb_matches;
+  double error;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hl_monitoring
+{
+/**
+ * Distortion models supported by the projection kernel, following OpenCV
+ * conventions for the order of the coefficients
+ */
+enum class DistortionModel
+{
+  /**
+   * Pinhole model
+   */
+  None,
+  /**
+   * Radial distortion: k1, k2
+   */
+  K1K2,
+  /**
+   * Radial and tangential distortion: k1, k2, p1, p2, k3
+   */
+  K1K2P1P2K3,
+  /**
+   * Rational radial distortion and tangential distortion: k1, k2, p1, p2, k3, k4, k5, k6
+   */
+  Rational
+};
+
+/**
+ * Return the simplest model handling the given number of distortion
+ * coefficients, missing coefficients are treated as zeros.
+ * Throws a std::out_of_range if there are more than 8 coefficients.
+ */
+DistortionModel getDistortionModel(int distortion_size);
+
+/**
+ * Parameters required to project points from field basis to image
+ */
+struct ProjectionParameters
+{
+  /**
+   * Rotation from field basis to camera basis (row-major)
+   */
+  float rotation[9];
+  float translation[3];
+  float fx, fy, cx, cy;
+  /**
+   * k1, k2, p1, p2, k3, k4, k5, k6, padded with zeros
+   */
+  float distortion[8];
+};
+
+/**
+ * Project 'nb_points' points given as separated arrays of coordinates (SoA)
+ * using the specified distortion model. Loops are free of branches and data
+ * dependencies so that the compiler processes several points per instruction.
+ *
+ * depth receives the coordinate of the points along the optical axis, points
+ * with a non-positive depth are behind the camera and their position in the
+ * image is meaningless.
+ *
+ * Buffers must not overlap.
+ */
+template <DistortionModel model>
+void projectFieldPoints(const ProjectionParameters& params, const float* __restrict x, const float* __restrict y,
+                        const float* __restrict z, size_t nb_points, float* __restrict u, float* __restrict v,
+                        float* __restrict depth);
+
+/**
+ * Dispatch to the kernel specialized for the given model
+ */
+void projectFieldPoints(DistortionModel model, const ProjectionParameters& params, const float* x, const float* y,
+                        const float* z, size_t nb_points, float* u, float* v, float* depth);
+
+}  // namespace hl_monitoring
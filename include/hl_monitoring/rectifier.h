@@ -0,0 +1,74 @@
+#pragma once
+
+#include "hl_monitoring/calibrated_image.h"
+
+namespace hl_monitoring
+{
+/**
+ * Produces undistorted images for a camera.
+ *
+ * Undistortion maps are computed in fixed-point format (CV_16SC2) once for
+ * given intrinsic parameters and reused until the parameters change. Images
+ * produced follow a pinhole model without distortion, whose parameters are
+ * provided by getRectifiedIntrinsic.
+ */
+class Rectifier
+{
+public:
+  /**
+   * alpha: free scaling parameter between 0 (only valid pixels are kept) and 1
+   *        (all source pixels are kept), see cv::getOptimalNewCameraMatrix
+   * nb_bands: number of horizontal bands remapped in parallel
+   */
+  Rectifier(double alpha = 0.0, int nb_bands = 1);
+
+  /**
+   * Update the intrinsic parameters of the source camera, maps are only
+   * rebuilt if parameters differ from the previous ones.
+   */
+  void setIntrinsic(const IntrinsicParameters& camera_parameters);
+
+  bool hasIntrinsic() const;
+
+  /**
+   * Intrinsic parameters of the rectified images: no distortion
+   */
+  const IntrinsicParameters& getRectifiedIntrinsic() const;
+
+  /**
+   * Write the undistorted version of src in dst, buffer of dst is reused if possible
+   */
+  void rectify(const cv::Mat& src, cv::Mat* dst) const;
+
+  /**
+   * Rectify the image using its own intrinsic parameters, returned image has
+   * the same pose and the rectified intrinsic parameters.
+   * Throws a std::runtime_error if img has no camera parameters.
+   */
+  CalibratedImage rectify(const CalibratedImage& img);
+
+private:
+  void updateMaps();
+
+  double alpha;
+
+  int nb_bands;
+
+  bool has_intrinsic;
+
+  IntrinsicParameters source_intrinsic;
+  IntrinsicParameters rectified_intrinsic;
+
+  /**
+   * Fixed-point undistortion maps: integer positions and interpolation table indices
+   */
+  cv::Mat map1;
+  cv::Mat map2;
+
+  /**
+   * Model used for the last rectified CalibratedImage
+   */
+  std::shared_ptr<const CameraModel> rectified_model;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Keeps the last seconds of a live stream in memory to allow fetching past
+ * frames, e.g. for instant replay while recording.
+ *
+ * Frames are compressed to JPEG by a worker thread, so that pushing a frame
+ * only costs a copy of the image. Frames older than the duration of the buffer
+ * relative to the most recent frame are dropped. If the worker cannot keep up
+ * with the stream, new frames are dropped once max_pending frames are waiting
+ * for compression.
+ *
+ * time_stamps are expected to be pushed in increasing order. All the methods
+ * are thread-safe.
+ */
+class ReplayBuffer
+{
+public:
+  /**
+   * duration: length of the window kept [s]
+   * jpeg_quality: quality used for compression in [0,100]
+   * max_pending: maximal number of frames waiting for compression
+   */
+  ReplayBuffer(double duration, int jpeg_quality = 85, size_t max_pending = 8);
+  ~ReplayBuffer();
+
+  ReplayBuffer(const ReplayBuffer& other) = delete;
+  ReplayBuffer& operator=(const ReplayBuffer& other) = delete;
+
+  /**
+   * Copy the image and schedule its compression
+   */
+  void push(uint64_t time_stamp, const cv::Mat& img);
+
+  /**
+   * Decode the most recent frame with a time_stamp lower or equal to time_stamp
+   * in img. Returns false if there is no such frame in the window. If
+   * frame_time_stamp is provided, it is filled with the time_stamp of the frame.
+   */
+  bool getImage(uint64_t time_stamp, cv::Mat* img, uint64_t* frame_time_stamp = nullptr) const;
+
+  /**
+   * time_stamps of the oldest and of the most recent frames available, 0 if
+   * buffer is empty
+   */
+  uint64_t getStart() const;
+  uint64_t getEnd() const;
+
+  /**
+   * Number of frames available, including the ones waiting for compression
+   */
+  size_t size() const;
+
+  /**
+   * Size of the compressed frames [bytes]
+   */
+  size_t getMemoryUsage() const;
+
+  /**
+   * Number of frames dropped because the worker could not keep up
+   */
+  size_t getNbDropped() const;
+
+private:
+  struct CompressedFrame
+  {
+    uint64_t time_stamp;
+    /**
+     * Shared with the readers decoding the frame, so that fetching a frame
+     * does not copy the data while the mutex is locked. Only modified by the
+     * worker before the frame is added to the buffer.
+     */
+    std::shared_ptr<std::vector<uchar>> data;
+  };
+
+  struct PendingFrame
+  {
+    uint64_t time_stamp;
+    cv::Mat img;
+  };
+
+  /**
+   * Main loop of the worker: compress pending frames until destruction
+   */
+  void compressFrames();
+
+  /**
+   * Drop the compressed frames outside of the window, mutex has to be locked
+   */
+  void dropOldFrames();
+
+  /**
+   * Duration of the window [us]
+   */
+  uint64_t duration;
+
+  int jpeg_quality;
+
+  size_t max_pending;
+
+  /**
+   * Compressed frames sorted by time_stamp
+   */
+  std::deque<CompressedFrame> frames;
+
+  /**
+   * Frames waiting for compression, all of them are more recent than frames
+   */
+  std::deque<PendingFrame> pending;
+
+  /**
+   * Buffers of previously compressed frames, reused to avoid allocating the
+   * images and the JPEG data of each frame
+   */
+  std::vector<cv::Mat> spare_images;
+  std::shared_ptr<std::vector<uchar>> spare_data;
+
+  size_t memory_usage;
+  size_t nb_dropped;
+
+  bool stop;
+
+  mutable std::mutex mutex;
+  std::condition_variable pending_condition;
+  std::thread worker;
+};
+
+}  // namespace hl_monitoring
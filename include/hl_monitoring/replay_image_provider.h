@@ -1,5 +1,6 @@
 #pragma once
 
+#include "hl_monitoring/frame_index.h"
 #include "hl_monitoring/image_provider.h"
 
 #include <opencv2/videoio.hpp>
@@ -14,11 +15,23 @@ public:
   ReplayImageProvider(const std::string& video_path, const std::string& meta_information_path);
 
   void loadVideo(const std::string& video_path);
+  /**
+   * Open the frame index of the meta information (see FrameIndex), it is built
+   * on first opening. Frame entries are not parsed: frames are accessed by
+   * binary search in the index
+   */
   void loadMetaInformation(const std::string& meta_information_path);
 
   void restartStream() override;
 
+  using ImageProvider::getCalibratedImage;
   CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
+  /**
+   * The image shares the buffer of the decoder and the camera model is updated
+   * in place when possible: no memory is allocated once out has been filled,
+   * apart from the decoding of new frames.
+   */
+  void getCalibratedImage(uint64_t time_stamp, CalibratedImage* out) override;
 
   cv::Mat getNextImg() override;
 
@@ -31,9 +44,30 @@ public:
    * Return the index of the last entry before given time_stamp, if there are no
    * entry before this time_stamp, returns -1
    */
-  int getIndex(uint64_t time_stamp) const;
+  int getIndex(uint64_t time_stamp);
+
+  /**
+   * Frame entries are built from the index on first call
+   */
+  const VideoMetaInformation& getMetaInformation() override;
+
+  uint64_t getFrameTimeStamp(uint64_t time_stamp) const override;
+
+  uint64_t getStart() const override;
+  uint64_t getEnd() const override;
 
 private:
+  /**
+   * Update last_img and frame_entry with the frame at the given time_stamp,
+   * returns false if there is no frame before time_stamp
+   */
+  bool loadFrame(uint64_t time_stamp);
+
+  /**
+   * Add the poses of the index to the pose timeline if it has not been done yet
+   */
+  void loadPoseTimeline();
+
   /**
    * The video read from the file
    */
@@ -43,6 +77,26 @@ private:
    * The last image retrieved
    */
   cv::Mat last_img;
+
+  /**
+   * Access to frame entries by time_stamp
+   */
+  FrameIndex frame_index;
+
+  /**
+   * Entry of the frame requested, built from the index
+   */
+  FrameEntry frame_entry;
+
+  /**
+   * Are the frames of meta_information filled with the content of the index
+   */
+  bool frames_loaded;
+
+  /**
+   * Have the poses of the index been added to the pose timeline
+   */
+  bool pose_timeline_loaded;
 };
 
 }  // namespace hl_monitoring
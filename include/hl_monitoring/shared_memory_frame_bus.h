@@ -0,0 +1,138 @@
+#pragma once
+
+#include "hl_monitoring/calibrated_image.h"
+
+#include <atomic>
+#include <string>
+
+namespace hl_monitoring
+{
+/**
+ * A frame bus is a POSIX shared memory segment containing a ring of frames
+ * written by a single process and read by any number of processes.
+ *
+ * Layout of the segment:
+ * - FrameBusHeader
+ * - nb_slots slots of slot_size bytes, each slot containing:
+ *   - FrameSlotHeader
+ *   - meta_capacity bytes for the serialized CameraMetaInformation
+ *   - The image data (img_step * img_height bytes)
+ *
+ * Frame number 'n' is written in slot 'n % nb_slots'. A sequence lock is used
+ * for each slot: while frame 'n' is written, the sequence of the slot is
+ * '2n+1', once writing is over, it is '2n+2'.
+ */
+struct FrameBusHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t nb_slots;
+  uint32_t slot_size;
+  uint32_t meta_capacity;
+  int32_t img_width;
+  int32_t img_height;
+  int32_t img_type;
+  uint32_t img_step;
+  /**
+   * Offset between steady_clock and system_clock [us]
+   */
+  std::atomic<int64_t> time_offset;
+  /**
+   * Number of frames published since the creation of the bus
+   */
+  std::atomic<uint64_t> nb_published;
+  /**
+   * Set to true when the publisher is closed
+   */
+  std::atomic<bool> closed;
+};
+
+struct FrameSlotHeader
+{
+  std::atomic<uint64_t> sequence;
+  std::atomic<uint64_t> time_stamp;
+  std::atomic<uint32_t> meta_size;
+};
+
+/**
+ * Size of the slot headers and meta-information is rounded to this alignment
+ */
+constexpr size_t frame_bus_alignment = 64;
+constexpr uint32_t frame_bus_magic = 0x484c4642;  // 'HLFB'
+constexpr uint32_t frame_bus_version = 1;
+
+/**
+ * Return the offset of the serialized CameraMetaInformation inside a slot
+ */
+size_t getFrameBusMetaOffset();
+
+/**
+ * Return the offset of the image data inside a slot
+ */
+size_t getFrameBusImageOffset(uint32_t meta_capacity);
+
+/**
+ * Return the offset of the first slot inside the shared memory segment
+ */
+size_t getFrameBusSlotsOffset();
+
+/**
+ * Create a frame bus and publish frames on it. The shared memory segment is
+ * removed when the publisher is destroyed, readers already attached keep their
+ * mapping.
+ *
+ * Creating a bus whose name is already used fails, unless unlink_existing is
+ * set: the existing segment is then unlinked, readers attached to it keep
+ * their mapping of the previous bus and have to reattach.
+ */
+class SharedMemoryFramePublisher
+{
+public:
+  /**
+   * name: name of the shared memory segment, e.g. '/hl_monitoring_camera0'
+   * meta_capacity: maximal size of the serialized CameraMetaInformation [bytes]
+   */
+  SharedMemoryFramePublisher(const std::string& name, const cv::Size& img_size, int img_type, int nb_slots = 8,
+                             size_t meta_capacity = 4096, bool unlink_existing = false);
+  ~SharedMemoryFramePublisher();
+
+  SharedMemoryFramePublisher(const SharedMemoryFramePublisher& other) = delete;
+  SharedMemoryFramePublisher& operator=(const SharedMemoryFramePublisher& other) = delete;
+
+  const std::string& getName() const;
+
+  /**
+   * Write the image along with its camera information in the next slot of the
+   * ring. Throws a std::runtime_error if size or type of the image do not match
+   * those of the bus.
+   */
+  void publish(uint64_t time_stamp, const CalibratedImage& img);
+
+  /**
+   * Set the offset in us between steady_clock and system_clock (time_since_epoch)
+   */
+  void setOffset(int64_t offset);
+
+private:
+  std::string name;
+
+  /**
+   * File descriptor of the shared memory segment
+   */
+  int fd;
+
+  /**
+   * Start and size of the mapping
+   */
+  uint8_t* data;
+  size_t data_size;
+
+  FrameBusHeader* header;
+
+  /**
+   * Serialization buffer for camera information, avoids reallocations
+   */
+  std::string meta_buffer;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/shared_memory_frame_bus.h"
+
+namespace hl_monitoring
+{
+/**
+ * Read frames published on a frame bus by a SharedMemoryFramePublisher,
+ * possibly from another process.
+ *
+ * Images returned are read-only views on the shared memory, no copy is
+ * performed. Since the bus is a ring, the content of an image is overwritten by
+ * the publisher after 'nb_slots' new frames have been published, consumers
+ * which need to keep images longer have to clone them.
+ *
+ * Any frame still present in the ring can be retrieved with getCalibratedImage.
+ */
+class SharedMemoryImageProvider : public ImageProvider
+{
+public:
+  /**
+   * Attach to an existing frame bus, throws a std::runtime_error on failure
+   */
+  SharedMemoryImageProvider(const std::string& bus_name);
+  virtual ~SharedMemoryImageProvider();
+
+  void restartStream() override;
+
+  using ImageProvider::getCalibratedImage;
+  CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
+
+  /**
+   * Synchronize the number of frames and the time offset with the publisher
+   */
+  void update() override;
+
+  /**
+   * Wait until a new frame is published and returns it. If the reader is late,
+   * frames which have already been overwritten are skipped.
+   */
+  cv::Mat getNextImg() override;
+
+  bool isStreamFinished() override;
+
+  uint64_t getFrameTimeStamp(uint64_t time_stamp) const override;
+
+  /**
+   * Return the time_stamp of the oldest frame still present in the ring, or the
+   * maximal value of uint64_t while nothing has been published
+   */
+  uint64_t getStart() const override;
+  uint64_t getEnd() const override;
+
+private:
+  /**
+   * Retrieve the frame with the given number, returns false if it is not
+   * available anymore (or not yet).
+   */
+  bool readFrame(uint64_t frame_number, cv::Mat* img, uint64_t* time_stamp, CameraMetaInformation* camera_meta) const;
+
+  /**
+   * Retrieve only the time_stamp of the frame with the given number, returns
+   * false if it is not available.
+   */
+  bool readTimeStamp(uint64_t frame_number, uint64_t* time_stamp) const;
+
+  /**
+   * Find the most recent frame with a time_stamp lower or equal to the given
+   * time_stamp, returns false if there is no such frame in the ring. Only the
+   * headers of the slots are read.
+   */
+  bool findFrame(uint64_t time_stamp, uint64_t* frame_number, uint64_t* frame_time_stamp) const;
+
+  /**
+   * Return the number of the oldest frame which can still be available
+   */
+  uint64_t getOldestFrameNumber() const;
+
+  std::string bus_name;
+
+  int fd;
+
+  uint8_t* data;
+  size_t data_size;
+
+  const FrameBusHeader* header;
+
+  /**
+   * time_stamp of the last frame published
+   */
+  uint64_t end;
+
+  /**
+   * Buffer used to parse the camera information of the frames
+   */
+  CameraMetaInformation frame_meta;
+
+  /**
+   * Model corresponding to the last camera information read
+   */
+  std::shared_ptr<const CameraModel> camera_model;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <hl_communication/message_manager.h>
+#include <hl_communication/wrapper.pb.h>
+
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Provides the status of the game provided by a MessageManager, the status is
+ * updated incrementally when time_stamps requested are monotonic.
+ *
+ * The status contains the most recent message from the GameController and the
+ * most recent message of each robot received before the requested time_stamp,
+ * identical to MessageManager::getStatus: time_stamps of the messages are
+ * expressed in system_clock while requests are in steady_clock, the offset of
+ * the manager is added to the requested time_stamp before comparison.
+ *
+ * The cursor keeps its own copy of the messages sorted by time_stamp and its
+ * position in this timeline, only the messages received between two requests
+ * are applied to the status. Messages received by a live manager are appended
+ * to the timeline when the end of the manager moves, messages older than the
+ * position of the cursor are applied immediately. The status is rebuilt from
+ * the beginning of the timeline only on backward seeks and offset changes.
+ */
+class StatusCursor
+{
+public:
+  /**
+   * The manager has to outlive the cursor
+   */
+  StatusCursor(hl_communication::MessageManager* manager);
+
+  /**
+   * Advance the cursor to the given time_stamp (steady_clock) and returns the
+   * status.
+   *
+   * The reference is valid until the next call to getStatus or reset.
+   */
+  const hl_communication::MessageManager::Status& getStatus(uint64_t time_stamp);
+
+  /**
+   * Drop the messages and the status, they are rebuilt on next request
+   */
+  void reset();
+
+  /**
+   * Number of times the status has been rebuilt from the beginning of the
+   * timeline since construction
+   */
+  size_t getNbRebuilds() const;
+
+private:
+  /**
+   * Refers to a message of the collection
+   */
+  struct Event
+  {
+    uint64_t time_stamp;
+    bool is_gc_msg;
+    int msg_index;
+  };
+
+  /**
+   * Copy the messages received by the manager since the last call and insert
+   * them in the timeline. Messages of the manager are expected to be kept in
+   * order of reception.
+   */
+  void loadNewMessages();
+
+  /**
+   * Rebuild the status from the beginning of the timeline up to message_time
+   */
+  void rebuild(uint64_t message_time);
+
+  /**
+   * Update the status with the message of the event if it is more recent than
+   * the message currently used
+   */
+  void apply(const Event& event);
+
+  hl_communication::MessageManager* manager;
+
+  /**
+   * Copy of the messages of the manager in order of reception
+   */
+  hl_communication::GameMsgCollection messages;
+
+  /**
+   * All the messages sorted by time_stamp, messages with the same time_stamp
+   * are sorted by order of reception
+   */
+  std::vector<Event> timeline;
+
+  /**
+   * Value of manager->getEnd() when messages were last loaded
+   */
+  uint64_t timeline_end;
+  bool has_timeline;
+
+  /**
+   * Index of the next event of the timeline to be applied
+   */
+  size_t next_event;
+
+  hl_communication::MessageManager::Status status;
+  bool has_status;
+
+  /**
+   * Requested time_stamp in the referential of the messages and offset of the
+   * manager for the current status
+   */
+  uint64_t status_message_time;
+  int64_t status_offset;
+
+  size_t nb_rebuilds;
+};
+
+}  // namespace hl_monitoring
@@ -4,6 +4,16 @@
 
 namespace hl_monitoring
 {
+/**
+ * Draws a top view of the field in two layers:
+ * - A static background (turf, lines, center, penalty marks and goals),
+ *   rendered once and cached until the field changes
+ * - Dynamic elements (robots, ball, annotations) drawn by the caller on a
+ *   copy of the background at every frame
+ *
+ * Since the background is cached, a single drawer should not be used
+ * concurrently from multiple threads.
+ */
 class TopViewDrawer
 {
 public:
@@ -15,6 +25,34 @@ public:
    */
   cv::Mat getImg(const Field& f) const;
 
+  /**
+   * Copy the background for the given field in dst, the buffer of dst is
+   * reused if possible
+   */
+  void getImg(const Field& f, cv::Mat* dst) const;
+
+  /**
+   * Draw a robot at the given position of the ground
+   */
+  void drawRobot(const Field& f, const cv::Point2f& pos_in_field, const cv::Scalar& color, cv::Mat* dst) const;
+
+  /**
+   * Draw a robot along with its orientation [rad] in field basis
+   */
+  void drawRobot(const Field& f, const cv::Point2f& pos_in_field, double orientation, const cv::Scalar& color,
+                 cv::Mat* dst) const;
+
+  /**
+   * Draw the ball at the given position of the ground
+   */
+  void drawBall(const Field& f, const cv::Point2f& pos_in_field, cv::Mat* dst) const;
+
+  /**
+   * Write a text next to the given position of the ground
+   */
+  void drawAnnotation(const Field& f, const cv::Point2f& pos_in_field, const std::string& text,
+                      const cv::Scalar& color, cv::Mat* dst) const;
+
   /**
    * Returns the scale of the field [px/m]
    */
@@ -26,6 +64,13 @@ public:
   cv::Point getImgFromField(const Field& f, const cv::Point3f& pos_in_field) const;
   cv::Point getImgFromField(const Field& f, const cv::Point2f& pos_in_field) const;
 
+  /**
+   * Return the position on the ground (field basis) corresponding to the given image point
+   */
+  cv::Point2f getFieldFromImg(const Field& f, const cv::Point2f& pos_in_img) const;
+
+  const cv::Size& getImgSize() const;
+
 private:
   /**
    * The size of the image to be generated
@@ -52,6 +97,45 @@ private:
    */
   cv::Scalar goals_color;
 
+  /**
+   * Color used for the ball
+   */
+  cv::Scalar ball_color;
+
+  /**
+   * Dimensions of the field used to render the cached background
+   */
+  struct BackgroundKey
+  {
+    double arena_length;
+    double arena_width;
+    double line_width;
+    double center_radius;
+    double penalty_mark_length;
+    std::vector<Field::Segment> white_lines;
+    std::vector<Field::Segment> goals;
+    std::vector<cv::Point3f> penalty_marks;
+  };
+
+  /**
+   * Return true if the cached background has been rendered for the given field
+   */
+  bool isBackgroundUpToDate(const Field& f) const;
+
+  /**
+   * Render the background if the cached version is outdated
+   */
+  void updateBackground(const Field& f) const;
+
+  /**
+   * Position of the given point in the image for a known scale [px/m]
+   */
+  cv::Point toImg(double scale, const cv::Point2f& pos_in_field) const;
+
+  mutable bool has_background;
+  mutable BackgroundKey background_key;
+  mutable cv::Mat background;
+
   /**
    * Return the width of the lines on image
    */
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "hl_monitoring/calibrated_image.h"
+#include "hl_monitoring/top_view_drawer.h"
+
+#include <map>
+#include <memory>
+
+namespace hl_monitoring
+{
+/**
+ * Builds a top view of the field by warping the images of all the calibrated
+ * cameras onto the ground plane and blending them.
+ *
+ * For each camera, a remap table associating every pixel of the top view to a
+ * pixel of the camera image is computed once and reused until the camera model
+ * or the geometry of the field change. Cameras are warped in parallel, areas
+ * seen by several cameras are averaged and areas seen by no camera show the
+ * synthetic view produced by the TopViewDrawer.
+ */
+class TopViewMosaic
+{
+public:
+  TopViewMosaic();
+  TopViewMosaic(const TopViewDrawer& drawer);
+
+  /**
+   * Return the mosaic built from all fully specified images, other images are ignored.
+   */
+  cv::Mat getImg(const Field& f, const std::map<std::string, CalibratedImage>& images);
+
+  /**
+   * Write the mosaic in dst, the buffer of dst is reused if possible
+   */
+  void getImg(const Field& f, const std::map<std::string, CalibratedImage>& images, cv::Mat* dst);
+
+  const TopViewDrawer& getDrawer() const;
+
+  /**
+   * Remove all cached tables
+   */
+  void clear();
+
+private:
+  struct WarpTable
+  {
+    /**
+     * Model used to build the table
+     */
+    std::shared_ptr<const CameraModel> camera_model;
+
+    /**
+     * Scale of the top view used to build the table [px/m]
+     */
+    double scale;
+
+    /**
+     * Fixed-point maps from top view pixels to camera pixels
+     */
+    cv::Mat map1;
+    cv::Mat map2;
+
+    /**
+     * Non-zero for the top view pixels seen by the camera
+     */
+    cv::Mat mask;
+
+    /**
+     * Buffer receiving the warped image
+     */
+    cv::Mat warped;
+  };
+
+  /**
+   * Return true if the table has been built for the given model and field
+   */
+  bool isUpToDate(const WarpTable& table, const Field& f, const std::shared_ptr<const CameraModel>& camera_model) const;
+
+  /**
+   * Compute the remap tables of the given camera
+   */
+  void updateTable(const Field& f, const std::shared_ptr<const CameraModel>& camera_model, WarpTable* table) const;
+
+  TopViewDrawer drawer;
+
+  std::map<std::string, WarpTable> tables;
+
+  /**
+   * Buffers used for blending, reused between calls
+   */
+  cv::Mat sum;
+  cv::Mat count;
+};
+
+}  // namespace hl_monitoring
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "hl_monitoring/camera.pb.h"
+#include "hl_monitoring/calibrated_image.h"
 
 #include <json/json.h>
 #include <opencv2/core.hpp>
@@ -20,6 +20,16 @@ void pose3DToCV(const Pose3D& pose, cv::Mat* rvec, cv::Mat* tvec);
 void cvToPose3D(const cv::Mat& rvec, const cv::Mat& tvec, Pose3D* pose);
 
 cv::Point2f fieldToImg(const cv::Point3f& pos_in_field, const CameraMetaInformation& camera_information);
+cv::Point2f fieldToImg(const cv::Point3f& pos_in_field, const CameraModel& camera_model);
+
+/**
+ * Project all the positions in each fully specified image of 'images' with a
+ * single call per camera. Entries of 'pos_in_imgs' and 'visible' are reused
+ * between calls to avoid reallocations. 'visible' can be nullptr.
+ */
+void fieldToImg(const std::vector<cv::Point3f>& pos_in_field, const std::map<std::string, CalibratedImage>& images,
+                std::map<std::string, std::vector<cv::Point2f>>* pos_in_imgs,
+                std::map<std::string, std::vector<uint8_t>>* visible);
 
 void checkMember(const Json::Value& v, const std::string& key);
 
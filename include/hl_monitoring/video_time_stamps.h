@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Return the presentation time_stamps of all the frames of the video in
+ * microseconds, relative to the first frame and sorted by presentation order.
+ *
+ * When built with HL_MONITORING_USES_LIBAV, packets are read from the container
+ * without decoding them. Otherwise, OpenCV is used to grab all the frames,
+ * which requires decoding.
+ *
+ * Throws a std::runtime_error if the video cannot be opened.
+ */
+std::vector<uint64_t> readVideoTimeStamps(const std::string& video_path);
+
+}  // namespace hl_monitoring
@@ -1,6 +1,6 @@
 #include "hl_monitoring/calibrated_image.h"
 
-#include "hl_monitoring/utils.h"
+#include <hl_communication/utils.h>
 
 #include <stdexcept>
 
@@ -13,12 +13,19 @@ CalibratedImage::CalibratedImage()
 CalibratedImage::CalibratedImage(const cv::Mat& img_, const Pose3D& pose, const IntrinsicParameters& camera_parameters)
   : img(img_)
 {
+  CameraMetaInformation camera_meta;
   camera_meta.mutable_pose()->CopyFrom(pose);
   camera_meta.mutable_camera_parameters()->CopyFrom(camera_parameters);
+  camera_model = std::make_shared<CameraModel>(camera_meta);
 }
 
-CalibratedImage::CalibratedImage(const cv::Mat& img_, const CameraMetaInformation& camera_meta_)
-  : img(img_), camera_meta(camera_meta_)
+CalibratedImage::CalibratedImage(const cv::Mat& img_, const CameraMetaInformation& camera_meta)
+  : img(img_), camera_model(std::make_shared<CameraModel>(camera_meta))
+{
+}
+
+CalibratedImage::CalibratedImage(const cv::Mat& img_, const std::shared_ptr<const CameraModel>& camera_model_)
+  : img(img_), camera_model(camera_model_)
 {
 }
 
@@ -27,19 +34,43 @@ const cv::Mat& CalibratedImage::getImg() const
   return img;
 }
 
+void CalibratedImage::clear()
+{
+  img.release();
+  camera_model.reset();
+}
+
 const CameraMetaInformation& CalibratedImage::getCameraInformation() const
 {
-  return camera_meta;
+  if (!camera_model)
+  {
+    return CameraMetaInformation::default_instance();
+  }
+  return camera_model->getCameraInformation();
+}
+
+const CameraModel& CalibratedImage::getCameraModel() const
+{
+  if (!camera_model)
+  {
+    throw std::logic_error(HL_DEBUG + " no camera model available");
+  }
+  return *camera_model;
+}
+
+const std::shared_ptr<const CameraModel>& CalibratedImage::getSharedCameraModel() const
+{
+  return camera_model;
 }
 
 bool CalibratedImage::hasCameraParameters() const
 {
-  return camera_meta.has_camera_parameters();
+  return camera_model && camera_model->hasCameraParameters();
 }
 
 bool CalibratedImage::hasPose() const
 {
-  return camera_meta.has_pose();
+  return camera_model && camera_model->hasPose();
 }
 
 void CalibratedImage::exportCameraParameters(cv::Mat* camera_matrix, cv::Mat* distortion_coefficients,
@@ -47,14 +78,17 @@ void CalibratedImage::exportCameraParameters(cv::Mat* camera_matrix, cv::Mat* di
 {
   if (hasCameraParameters())
   {
-    intrinsicToCV(camera_meta.camera_parameters(), camera_matrix, distortion_coefficients, size);
+    camera_model->getCameraMatrix().copyTo(*camera_matrix);
+    camera_model->getDistortionCoefficients().copyTo(*distortion_coefficients);
+    *size = camera_model->getImgSize();
   }
 }
 void CalibratedImage::exportPose(cv::Mat* rvec, cv::Mat* tvec) const
 {
   if (hasPose())
   {
-    pose3DToCV(camera_meta.pose(), rvec, tvec);
+    camera_model->getRVec().copyTo(*rvec);
+    camera_model->getTVec().copyTo(*tvec);
   }
 }
 
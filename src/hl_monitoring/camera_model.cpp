@@ -0,0 +1,462 @@
+#include "hl_monitoring/camera_model.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/utils.h>
+
+#include <opencv2/calib3d.hpp>
+
+#include <algorithm>
+
+namespace hl_monitoring
+{
+constexpr int CameraModel::max_fast_distortion_size;
+
+/**
+ * Same requirements as pose3DToCV
+ */
+static void checkPoseFormat(const Pose3D& pose)
+{
+  if (pose.rotation_size() != 3)
+  {
+    throw std::runtime_error("Only Rodrigues rotation vector is supported currently");
+  }
+  if (pose.translation_size() != 3)
+  {
+    throw std::runtime_error("Size of translation in Pose3D is not valid (only 3 is accepted)");
+  }
+}
+
+/**
+ * Project a point in normalized camera coordinates on a plane using the
+ * homography h, returns false if the plane is behind the camera along the ray
+ */
+static bool normalizedToPlane(const cv::Matx33d& h, const cv::Point2f& normalized, double height,
+                              cv::Point3f* pos_in_field)
+{
+  double x = normalized.x;
+  double y = normalized.y;
+  double px = h(0, 0) * x + h(0, 1) * y + h(0, 2);
+  double py = h(1, 0) * x + h(1, 1) * y + h(1, 2);
+  double w = h(2, 0) * x + h(2, 1) * y + h(2, 2);
+  // w is the inverse of the depth of the point along the ray
+  if (w <= 0)
+  {
+    *pos_in_field = cv::Point3f(0, 0, height);
+    return false;
+  }
+  *pos_in_field = cv::Point3f(px / w, py / w, height);
+  return true;
+}
+
+CameraModel::CameraModel(const CameraMetaInformation& camera_meta_)
+  : camera_meta(camera_meta_), distortion_model(DistortionModel::None), use_projection_kernel(false)
+{
+  std::fill(distortion, distortion + max_fast_distortion_size, 0.0);
+  if (hasCameraParameters())
+  {
+    intrinsicToCV(camera_meta.camera_parameters(), &camera_matrix, &distortion_coefficients, &img_size);
+    for (int i = 0; i < std::min(distortion_coefficients.cols, max_fast_distortion_size); i++)
+    {
+      distortion[i] = distortion_coefficients.at<double>(0, i);
+    }
+  }
+  if (hasPose())
+  {
+    updatePose();
+  }
+}
+
+void CameraModel::setPose(const Pose3D& pose)
+{
+  checkPoseFormat(pose);
+  camera_meta.mutable_pose()->CopyFrom(pose);
+  updatePose();
+}
+
+void CameraModel::updatePose()
+{
+  const Pose3D& pose = camera_meta.pose();
+  checkPoseFormat(pose);
+  // Buffers are only allocated for the first pose
+  rvec.create(3, 1, CV_64F);
+  tvec.create(3, 1, CV_64F);
+  for (int i = 0; i < 3; i++)
+  {
+    rvec.at<double>(i, 0) = pose.rotation(i);
+    tvec.at<double>(i, 0) = pose.translation(i);
+  }
+  cv::Rodrigues(rvec, rotation);
+  inverse_rotation = rotation.t();
+  cv::Vec3d translation(tvec.at<double>(0, 0), tvec.at<double>(1, 0), tvec.at<double>(2, 0));
+  camera_position = -(inverse_rotation * translation);
+  normalized_to_ground = getNormalizedToPlane(0);
+  if (hasCameraParameters())
+  {
+    cv::Matx33d k = camera_matrix;
+    ground_homography = k * normalized_to_ground.inv();
+    use_projection_kernel = distortion_coefficients.cols <= max_fast_distortion_size;
+    if (use_projection_kernel)
+    {
+      distortion_model = getDistortionModel(distortion_coefficients.cols);
+      for (int i = 0; i < 9; i++)
+      {
+        projection_parameters.rotation[i] = rotation(i / 3, i % 3);
+      }
+      for (int i = 0; i < 3; i++)
+      {
+        projection_parameters.translation[i] = tvec.at<double>(i, 0);
+      }
+      projection_parameters.fx = k(0, 0);
+      projection_parameters.fy = k(1, 1);
+      projection_parameters.cx = k(0, 2);
+      projection_parameters.cy = k(1, 2);
+      for (int i = 0; i < max_fast_distortion_size; i++)
+      {
+        projection_parameters.distortion[i] = distortion[i];
+      }
+    }
+  }
+}
+
+const CameraMetaInformation& CameraModel::getCameraInformation() const
+{
+  return camera_meta;
+}
+
+bool CameraModel::hasCameraParameters() const
+{
+  return camera_meta.has_camera_parameters();
+}
+
+bool CameraModel::hasPose() const
+{
+  return camera_meta.has_pose();
+}
+
+bool CameraModel::isFullySpecified() const
+{
+  return hasPose() && hasCameraParameters();
+}
+
+bool CameraModel::matches(const IntrinsicParameters* camera_parameters, const Pose3D* pose) const
+{
+  const IntrinsicParameters* own_parameters = hasCameraParameters() ? &camera_meta.camera_parameters() : nullptr;
+  const Pose3D* own_pose = hasPose() ? &camera_meta.pose() : nullptr;
+  return isSameIntrinsic(own_parameters, camera_parameters) && isSamePose(own_pose, pose);
+}
+
+const cv::Mat& CameraModel::getCameraMatrix() const
+{
+  checkCameraParameters();
+  return camera_matrix;
+}
+
+const cv::Mat& CameraModel::getDistortionCoefficients() const
+{
+  checkCameraParameters();
+  return distortion_coefficients;
+}
+
+const cv::Size& CameraModel::getImgSize() const
+{
+  checkCameraParameters();
+  return img_size;
+}
+
+const cv::Mat& CameraModel::getRVec() const
+{
+  checkPose();
+  return rvec;
+}
+
+const cv::Mat& CameraModel::getTVec() const
+{
+  checkPose();
+  return tvec;
+}
+
+const cv::Matx33d& CameraModel::getRotation() const
+{
+  checkPose();
+  return rotation;
+}
+
+const cv::Matx33d& CameraModel::getInverseRotation() const
+{
+  checkPose();
+  return inverse_rotation;
+}
+
+const cv::Vec3d& CameraModel::getCameraPosition() const
+{
+  checkPose();
+  return camera_position;
+}
+
+cv::Point2f CameraModel::fieldToImg(const cv::Point3f& pos_in_field) const
+{
+  cv::Point2f pos_in_img;
+  fieldToImg(&pos_in_field, 1, &pos_in_img);
+  return pos_in_img;
+}
+
+void CameraModel::fieldToImg(const cv::Point3f* pos_in_field, size_t nb_points, cv::Point2f* pos_in_img,
+                             uint8_t* visible) const
+{
+  if (!isFullySpecified())
+  {
+    throw std::runtime_error(HL_DEBUG + " camera model is not fully specified");
+  }
+  if (nb_points == 0)
+  {
+    return;
+  }
+  cv::Rect2f img_rect(0, 0, img_size.width, img_size.height);
+  if (!use_projection_kernel)
+  {
+    // Headers on caller buffers: since output has the expected size and type,
+    // OpenCV writes directly in it
+    cv::Mat object_points(nb_points, 1, CV_32FC3, (void*)pos_in_field);
+    cv::Mat img_points(nb_points, 1, CV_32FC2, (void*)pos_in_img);
+    cv::projectPoints(object_points, rvec, tvec, camera_matrix, distortion_coefficients, img_points);
+    if (visible != nullptr)
+    {
+      for (size_t idx = 0; idx < nb_points; idx++)
+      {
+        visible[idx] = isInFront(pos_in_field[idx]) && img_rect.contains(pos_in_img[idx]);
+      }
+    }
+    return;
+  }
+  // Points are converted to SoA by blocks small enough to stay in L1 cache
+  const size_t block_size = 256;
+  float x[block_size], y[block_size], z[block_size];
+  float u[block_size], v[block_size], depth[block_size];
+  for (size_t start = 0; start < nb_points; start += block_size)
+  {
+    size_t block_points = std::min(block_size, nb_points - start);
+    const cv::Point3f* src = pos_in_field + start;
+    for (size_t idx = 0; idx < block_points; idx++)
+    {
+      x[idx] = src[idx].x;
+      y[idx] = src[idx].y;
+      z[idx] = src[idx].z;
+    }
+    projectFieldPoints(distortion_model, projection_parameters, x, y, z, block_points, u, v, depth);
+    cv::Point2f* dst = pos_in_img + start;
+    for (size_t idx = 0; idx < block_points; idx++)
+    {
+      dst[idx] = cv::Point2f(u[idx], v[idx]);
+    }
+    if (visible != nullptr)
+    {
+      for (size_t idx = 0; idx < block_points; idx++)
+      {
+        visible[start + idx] = depth[idx] > 0 && img_rect.contains(dst[idx]);
+      }
+    }
+  }
+}
+
+void CameraModel::fieldToImg(const std::vector<cv::Point3f>& pos_in_field, std::vector<cv::Point2f>* pos_in_img,
+                             std::vector<uint8_t>* visible) const
+{
+  pos_in_img->resize(pos_in_field.size());
+  uint8_t* visible_data = nullptr;
+  if (visible != nullptr)
+  {
+    visible->resize(pos_in_field.size());
+    visible_data = visible->data();
+  }
+  fieldToImg(pos_in_field.data(), pos_in_field.size(), pos_in_img->data(), visible_data);
+}
+
+bool CameraModel::isInFront(const cv::Point3f& pos_in_field) const
+{
+  checkPose();
+  double z = rotation(2, 0) * pos_in_field.x + rotation(2, 1) * pos_in_field.y + rotation(2, 2) * pos_in_field.z +
+             tvec.at<double>(2, 0);
+  return z > 0;
+}
+
+void CameraModel::undistortPoints(const cv::Point2f* pos_in_img, size_t nb_points, cv::Point2f* normalized) const
+{
+  checkCameraParameters();
+  if (nb_points == 0)
+  {
+    return;
+  }
+  if (distortion_coefficients.cols > max_fast_distortion_size)
+  {
+    cv::Mat src(nb_points, 1, CV_32FC2, (void*)pos_in_img);
+    cv::Mat dst(nb_points, 1, CV_32FC2, (void*)normalized);
+    cv::undistortPoints(src, dst, camera_matrix, distortion_coefficients);
+    return;
+  }
+  double fx = camera_matrix.at<double>(0, 0);
+  double fy = camera_matrix.at<double>(1, 1);
+  double cx = camera_matrix.at<double>(0, 2);
+  double cy = camera_matrix.at<double>(1, 2);
+  double k1 = distortion[0], k2 = distortion[1], p1 = distortion[2], p2 = distortion[3];
+  double k3 = distortion[4], k4 = distortion[5], k5 = distortion[6], k6 = distortion[7];
+  // Same fixed-point iteration as OpenCV, written without branches to allow vectorization
+  const int nb_iterations = 8;
+  for (size_t idx = 0; idx < nb_points; idx++)
+  {
+    double x0 = (pos_in_img[idx].x - cx) / fx;
+    double y0 = (pos_in_img[idx].y - cy) / fy;
+    double x = x0;
+    double y = y0;
+    for (int iter = 0; iter < nb_iterations; iter++)
+    {
+      double r2 = x * x + y * y;
+      double inv_radial = (1 + ((k6 * r2 + k5) * r2 + k4) * r2) / (1 + ((k3 * r2 + k2) * r2 + k1) * r2);
+      double delta_x = 2 * p1 * x * y + p2 * (r2 + 2 * x * x);
+      double delta_y = p1 * (r2 + 2 * y * y) + 2 * p2 * x * y;
+      x = (x0 - delta_x) * inv_radial;
+      y = (y0 - delta_y) * inv_radial;
+    }
+    normalized[idx] = cv::Point2f(x, y);
+  }
+}
+
+bool CameraModel::imgToField(const cv::Point2f& pos_in_img, cv::Point3f* pos_in_field, double height) const
+{
+  if (!isFullySpecified())
+  {
+    throw std::runtime_error(HL_DEBUG + " camera model is not fully specified");
+  }
+  cv::Point2f normalized;
+  undistortPoints(&pos_in_img, 1, &normalized);
+  return normalizedToPlane(height == 0 ? normalized_to_ground : getNormalizedToPlane(height), normalized, height,
+                           pos_in_field);
+}
+
+void CameraModel::imgToField(const cv::Point2f* pos_in_img, size_t nb_points, cv::Point3f* pos_in_field,
+                             uint8_t* valid, double height) const
+{
+  if (!isFullySpecified())
+  {
+    throw std::runtime_error(HL_DEBUG + " camera model is not fully specified");
+  }
+  cv::Matx33d h = height == 0 ? normalized_to_ground : getNormalizedToPlane(height);
+  // Normalized points are computed by blocks on the stack, as in fieldToImg
+  const size_t block_size = 256;
+  cv::Point2f normalized[block_size];
+  for (size_t start = 0; start < nb_points; start += block_size)
+  {
+    size_t block_points = std::min(block_size, nb_points - start);
+    undistortPoints(pos_in_img + start, block_points, normalized);
+    for (size_t idx = 0; idx < block_points; idx++)
+    {
+      bool is_valid = normalizedToPlane(h, normalized[idx], height, pos_in_field + start + idx);
+      if (valid != nullptr)
+      {
+        valid[start + idx] = is_valid;
+      }
+    }
+  }
+}
+
+void CameraModel::imgToField(const std::vector<cv::Point2f>& pos_in_img, std::vector<cv::Point3f>* pos_in_field,
+                             std::vector<uint8_t>* valid, double height) const
+{
+  pos_in_field->resize(pos_in_img.size());
+  uint8_t* valid_data = nullptr;
+  if (valid != nullptr)
+  {
+    valid->resize(pos_in_img.size());
+    valid_data = valid->data();
+  }
+  imgToField(pos_in_img.data(), pos_in_img.size(), pos_in_field->data(), valid_data, height);
+}
+
+const cv::Matx33d& CameraModel::getGroundHomography() const
+{
+  if (!isFullySpecified())
+  {
+    throw std::logic_error(HL_DEBUG + " camera model is not fully specified");
+  }
+  return ground_homography;
+}
+
+void CameraModel::checkCameraParameters() const
+{
+  if (!hasCameraParameters())
+  {
+    throw std::logic_error(HL_DEBUG + " camera model has no camera parameters");
+  }
+}
+
+void CameraModel::checkPose() const
+{
+  if (!hasPose())
+  {
+    throw std::logic_error(HL_DEBUG + " camera model has no pose");
+  }
+}
+
+cv::Matx33d CameraModel::getNormalizedToPlane(double height) const
+{
+  // A point (x,y,height) of the plane is seen at: R * (x,y,height) + t = [r1 r2 r3*height+t] * (x,y,1)
+  const cv::Mat& t = tvec;
+  cv::Matx33d plane_to_normalized;
+  for (int row = 0; row < 3; row++)
+  {
+    plane_to_normalized(row, 0) = rotation(row, 0);
+    plane_to_normalized(row, 1) = rotation(row, 1);
+    plane_to_normalized(row, 2) = rotation(row, 2) * height + t.at<double>(row, 0);
+  }
+  return plane_to_normalized.inv();
+}
+
+bool isSameIntrinsic(const IntrinsicParameters* p1, const IntrinsicParameters* p2)
+{
+  if (p1 == nullptr || p2 == nullptr)
+  {
+    return p1 == p2;
+  }
+  if (p1->focal_x() != p2->focal_x() || p1->focal_y() != p2->focal_y() || p1->center_x() != p2->center_x() ||
+      p1->center_y() != p2->center_y() || p1->img_width() != p2->img_width() ||
+      p1->img_height() != p2->img_height() || p1->distortion_size() != p2->distortion_size())
+  {
+    return false;
+  }
+  for (int i = 0; i < p1->distortion_size(); i++)
+  {
+    if (p1->distortion(i) != p2->distortion(i))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool isSamePose(const Pose3D* p1, const Pose3D* p2)
+{
+  if (p1 == nullptr || p2 == nullptr)
+  {
+    return p1 == p2;
+  }
+  if (p1->rotation_size() != p2->rotation_size() || p1->translation_size() != p2->translation_size())
+  {
+    return false;
+  }
+  for (int i = 0; i < p1->rotation_size(); i++)
+  {
+    if (p1->rotation(i) != p2->rotation(i))
+    {
+      return false;
+    }
+  }
+  for (int i = 0; i < p1->translation_size(); i++)
+  {
+    if (p1->translation(i) != p2->translation(i))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,155 @@
+#include "hl_monitoring/clock_synchronizer.h"
+
+#include <hl_communication/utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Return the median of the values, order of values is modified
+ */
+static double median(std::vector<double>* values)
+{
+  size_t middle = values->size() / 2;
+  std::nth_element(values->begin(), values->begin() + middle, values->end());
+  return (*values)[middle];
+}
+
+static int64_t toMicroseconds(std::chrono::nanoseconds duration)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+ClockSynchronizer::ClockSynchronizer(size_t max_samples_)
+  : max_samples(max_samples_), base_reference(0), base_offset(0), intercept(0), drift(0), uncertainty(0)
+{
+  if (max_samples < 1)
+  {
+    throw std::logic_error(HL_DEBUG + "at least one sample is required");
+  }
+}
+
+void ClockSynchronizer::addSample(int64_t reference, int64_t target)
+{
+  samples.push_back({ reference, target });
+  while (samples.size() > max_samples)
+  {
+    samples.pop_front();
+  }
+  updateEstimate();
+}
+
+void ClockSynchronizer::sampleSystemClock()
+{
+  const int nb_attempts = 5;
+  int64_t best_latency = 0;
+  Sample best_sample{ 0, 0 };
+  for (int attempt = 0; attempt < nb_attempts; attempt++)
+  {
+    int64_t steady_before = toMicroseconds(std::chrono::steady_clock::now().time_since_epoch());
+    int64_t system = toMicroseconds(std::chrono::system_clock::now().time_since_epoch());
+    int64_t steady_after = toMicroseconds(std::chrono::steady_clock::now().time_since_epoch());
+    int64_t latency = steady_after - steady_before;
+    if (attempt == 0 || latency < best_latency)
+    {
+      best_latency = latency;
+      best_sample = { steady_before + latency / 2, system };
+    }
+  }
+  addSample(best_sample.reference, best_sample.target);
+}
+
+bool ClockSynchronizer::hasEstimate() const
+{
+  return !samples.empty();
+}
+
+size_t ClockSynchronizer::getNbSamples() const
+{
+  return samples.size();
+}
+
+int64_t ClockSynchronizer::getOffset(int64_t reference) const
+{
+  if (samples.empty())
+  {
+    throw std::logic_error(HL_DEBUG + "no samples available");
+  }
+  return base_offset + (int64_t)std::llround(intercept + drift * (reference - base_reference));
+}
+
+int64_t ClockSynchronizer::getOffset() const
+{
+  if (samples.empty())
+  {
+    throw std::logic_error(HL_DEBUG + "no samples available");
+  }
+  return getOffset(samples.back().reference);
+}
+
+double ClockSynchronizer::getDrift() const
+{
+  return drift;
+}
+
+double ClockSynchronizer::getUncertainty() const
+{
+  return uncertainty;
+}
+
+void ClockSynchronizer::clear()
+{
+  samples.clear();
+  intercept = 0;
+  drift = 0;
+  uncertainty = 0;
+}
+
+void ClockSynchronizer::updateEstimate()
+{
+  size_t nb_samples = samples.size();
+  base_reference = samples.front().reference;
+  base_offset = samples.front().target - samples.front().reference;
+  std::vector<double> x(nb_samples), y(nb_samples);
+  for (size_t idx = 0; idx < nb_samples; idx++)
+  {
+    x[idx] = samples[idx].reference - base_reference;
+    y[idx] = (samples[idx].target - samples[idx].reference) - base_offset;
+  }
+  // Slopes between samples half a window apart: robust and well conditioned
+  drift = 0;
+  size_t half = nb_samples / 2;
+  std::vector<double> values;
+  for (size_t idx = 0; idx + half < nb_samples && half > 0; idx++)
+  {
+    double dx = x[idx + half] - x[idx];
+    if (dx > 0)
+    {
+      values.push_back((y[idx + half] - y[idx]) / dx);
+    }
+  }
+  if (!values.empty())
+  {
+    drift = median(&values);
+  }
+  values.clear();
+  for (size_t idx = 0; idx < nb_samples; idx++)
+  {
+    values.push_back(y[idx] - drift * x[idx]);
+  }
+  std::vector<double> residuals = values;
+  intercept = median(&values);
+  for (double& residual : residuals)
+  {
+    residual = std::fabs(residual - intercept);
+  }
+  // 1.4826 * MAD is a consistent estimator of the standard deviation for gaussian noise
+  double sigma = 1.4826 * median(&residuals);
+  uncertainty = sigma / std::sqrt((double)nb_samples);
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,278 @@
+#include "hl_monitoring/encoder_settings.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/utils.h>
+
+#include <opencv2/core/version.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+namespace hl_monitoring
+{
+static std::map<std::string, EncoderSettings> buildPresets()
+{
+  std::map<std::string, EncoderSettings> presets;
+  EncoderSettings legacy;
+  presets["legacy"] = legacy;
+
+  EncoderSettings fast_lossless;
+  fast_lossless.codec = "FFV1";
+  fast_lossless.container = "mkv";
+  // Slices are required for multithreading in FFV1
+  fast_lossless.options = "level;3|slices;16";
+  presets["fast_lossless"] = fast_lossless;
+
+  EncoderSettings cheap_intra;
+  cheap_intra.codec = "MJPG";
+  cheap_intra.backend = "opencv_mjpeg";
+  cheap_intra.quality = 90;
+  presets["cheap_intra"] = cheap_intra;
+
+  EncoderSettings compact;
+  compact.codec = "avc1";
+  compact.container = "mp4";
+  compact.quality = 55;
+  // Two seconds at 30 fps: seeking stays reasonably fast during replay
+  compact.gop = 60;
+  compact.options = "preset;veryfast";
+  presets["compact"] = compact;
+  return presets;
+}
+
+static const std::map<std::string, EncoderSettings>& getPresets()
+{
+  // Initialization of static local variables is thread-safe
+  static const std::map<std::string, EncoderSettings> presets = buildPresets();
+  return presets;
+}
+
+/**
+ * OPENCV_FFMPEG_WRITER_OPTIONS is ignored by older versions of OpenCV
+ */
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+#define HL_MONITORING_FFMPEG_WRITER_OPTIONS
+static const bool ffmpeg_writer_options_supported = true;
+#else
+static const bool ffmpeg_writer_options_supported = false;
+#endif
+
+/**
+ * Environment is shared by the whole process while providers are opened in
+ * parallel
+ */
+static std::mutex environment_mutex;
+
+std::unique_lock<std::mutex> lockVideoEnvironment()
+{
+  return std::unique_lock<std::mutex>(environment_mutex);
+}
+
+static bool isH264(const std::string& codec)
+{
+  return codec == "avc1" || codec == "H264" || codec == "X264";
+}
+
+EncoderSettings::EncoderSettings()
+  : codec("XVID"), container("avi"), backend("any"), quality(-1), threads(0), gop(-1)
+{
+}
+
+EncoderSettings EncoderSettings::getPreset(const std::string& name)
+{
+  const std::map<std::string, EncoderSettings>& presets = getPresets();
+  auto it = presets.find(name);
+  if (it == presets.end())
+  {
+    throw std::out_of_range(HL_DEBUG + "unknown encoder preset '" + name + "'");
+  }
+  return it->second;
+}
+
+std::vector<std::string> EncoderSettings::getPresetNames()
+{
+  std::vector<std::string> names;
+  for (const auto& entry : getPresets())
+  {
+    names.push_back(entry.first);
+  }
+  return names;
+}
+
+Json::Value EncoderSettings::toJson() const
+{
+  Json::Value v;
+  v["codec"] = codec;
+  v["container"] = container;
+  v["backend"] = backend;
+  v["quality"] = quality;
+  v["threads"] = threads;
+  v["gop"] = gop;
+  v["options"] = options;
+  return v;
+}
+
+void EncoderSettings::fromJson(const Json::Value& v)
+{
+  if (v.isString())
+  {
+    *this = getPreset(v.asString());
+    return;
+  }
+  if (!v.isObject())
+  {
+    throw std::runtime_error(HL_DEBUG + " invalid type for encoder settings, expecting a string or an object");
+  }
+  std::string preset;
+  tryReadVal(v, "preset", &preset);
+  if (preset != "")
+  {
+    *this = getPreset(preset);
+  }
+  tryReadVal(v, "codec", &codec);
+  tryReadVal(v, "container", &container);
+  tryReadVal(v, "backend", &backend);
+  tryReadVal(v, "quality", &quality);
+  tryReadVal(v, "threads", &threads);
+  tryReadVal(v, "gop", &gop);
+  tryReadVal(v, "options", &options);
+  if (codec.size() != 4)
+  {
+    throw std::runtime_error(HL_DEBUG + " codec should be a four characters code, received '" + codec + "'");
+  }
+  if (quality < -1 || quality > 100)
+  {
+    throw std::runtime_error(HL_DEBUG + " quality should be in [0,100] or -1, received " + std::to_string(quality));
+  }
+}
+
+std::string EncoderSettings::getPath(const std::string& prefix) const
+{
+  return prefix + "." + container;
+}
+
+bool EncoderSettings::requiresFFmpegOptions() const
+{
+  return threads > 0 || gop > 0 || options != "" || (quality >= 0 && isH264(codec));
+}
+
+std::string EncoderSettings::getFFmpegOptions() const
+{
+  std::vector<std::string> entries;
+  if (threads > 0)
+  {
+    entries.push_back("threads;" + std::to_string(threads));
+  }
+  if (gop > 0)
+  {
+    entries.push_back("g;" + std::to_string(gop));
+  }
+  if (quality >= 0 && isH264(codec))
+  {
+    // Constant rate factor of x264 ranges from 0 (lossless) to 51 (worst)
+    entries.push_back("crf;" + std::to_string((int)std::round(51 * (100 - quality) / 100.0)));
+  }
+  if (options != "")
+  {
+    entries.push_back(options);
+  }
+  std::string result;
+  for (const std::string& entry : entries)
+  {
+    result += (result == "" ? "" : "|") + entry;
+  }
+  return result;
+}
+
+void EncoderSettings::open(const std::string& path, double fps, const cv::Size& img_size, bool use_color,
+                           cv::VideoWriter* writer) const
+{
+  int api_preference = cv::CAP_ANY;
+  if (backend == "ffmpeg")
+  {
+    api_preference = cv::CAP_FFMPEG;
+  }
+  else if (backend == "opencv_mjpeg")
+  {
+    api_preference = cv::CAP_OPENCV_MJPEG;
+  }
+  else if (backend != "any")
+  {
+    throw std::runtime_error(HL_DEBUG + " unknown backend '" + backend + "'");
+  }
+  if (backend == "opencv_mjpeg")
+  {
+    // Threads are used as stripes and quality is supported, other settings are specific to FFmpeg
+    if (gop > 0 || options != "")
+    {
+      throw std::runtime_error(HL_DEBUG + " gop and options are not supported by backend '" + backend + "'");
+    }
+  }
+  else
+  {
+    if (!ffmpeg_writer_options_supported && requiresFFmpegOptions())
+    {
+      throw std::runtime_error(HL_DEBUG + " threads, gop, quality and options require OpenCV 4.6 or later, found " +
+                               CV_VERSION + ", received options '" + getFFmpegOptions() + "'");
+    }
+    if (quality >= 0 && !isH264(codec))
+    {
+      throw std::runtime_error(HL_DEBUG + " quality is not supported for codec '" + codec + "' with backend '" +
+                               backend + "'");
+    }
+  }
+  int fourcc = cv::VideoWriter::fourcc(codec[0], codec[1], codec[2], codec[3]);
+  std::unique_lock<std::mutex> lock = lockVideoEnvironment();
+  if (!ffmpeg_writer_options_supported || backend == "opencv_mjpeg")
+  {
+    writer->open(path, api_preference, fourcc, fps, img_size, use_color);
+  }
+  else
+  {
+    const char* env_name = "OPENCV_FFMPEG_WRITER_OPTIONS";
+    const char* previous_value = getenv(env_name);
+    std::string previous_options = previous_value == nullptr ? "" : previous_value;
+    setenv(env_name, getFFmpegOptions().c_str(), 1);
+    writer->open(path, api_preference, fourcc, fps, img_size, use_color);
+    if (previous_value == nullptr)
+    {
+      unsetenv(env_name);
+    }
+    else
+    {
+      setenv(env_name, previous_options.c_str(), 1);
+    }
+  }
+  lock.unlock();
+  if (!writer->isOpened())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open video at '" + path + "' with codec '" + codec + "'");
+  }
+#ifdef HL_MONITORING_FFMPEG_WRITER_OPTIONS
+  // With backend 'any', OpenCV may have chosen a backend which ignores the options
+  std::string backend_name = writer->getBackendName();
+  if (backend != "opencv_mjpeg" && requiresFFmpegOptions() && backend_name != "FFMPEG")
+  {
+    writer->release();
+    throw std::runtime_error(HL_DEBUG + " options '" + getFFmpegOptions() + "' cannot be applied by backend '" +
+                             backend_name + "'");
+  }
+#endif
+  if (backend == "opencv_mjpeg")
+  {
+    if (quality >= 0 && !writer->set(cv::VIDEOWRITER_PROP_QUALITY, quality))
+    {
+      writer->release();
+      throw std::runtime_error(HL_DEBUG + " failed to set quality of '" + path + "'");
+    }
+    // Built-in MJPEG encoder splits images in stripes encoded in parallel
+    if (!writer->set(cv::VIDEOWRITER_PROP_NSTRIPES, threads > 0 ? threads : -1))
+    {
+      writer->release();
+      throw std::runtime_error(HL_DEBUG + " failed to set number of stripes of '" + path + "'");
+    }
+  }
+}
+
+}  // namespace hl_monitoring
@@ -7,10 +7,95 @@
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <cmath>
 #include <fstream>
 
 namespace hl_monitoring
 {
+/**
+ * Points closer than this distance to the camera plane are not drawn [m]
+ */
+static const double near_plane_distance = 0.01;
+
+/**
+ * Maximal length of a segment when drawing lines with a distorted camera [px]
+ */
+static const double max_segment_length_px = 20;
+
+static const int max_segments_per_line = 200;
+
+/**
+ * Computes the part of a segment in front of the near plane based on the depth
+ * of its extremities in the camera basis. Returns false if the whole segment is
+ * behind the plane, otherwise start and end of the visible part are written as
+ * ratios of the segment.
+ */
+static bool clipToNearPlane(double src_depth, double dst_depth, double* start_ratio, double* end_ratio)
+{
+  *start_ratio = 0;
+  *end_ratio = 1;
+  if (src_depth < near_plane_distance && dst_depth < near_plane_distance)
+  {
+    return false;
+  }
+  if (src_depth < near_plane_distance)
+  {
+    *start_ratio = (near_plane_distance - src_depth) / (dst_depth - src_depth);
+  }
+  else if (dst_depth < near_plane_distance)
+  {
+    *end_ratio = (near_plane_distance - src_depth) / (dst_depth - src_depth);
+  }
+  return true;
+}
+
+/**
+ * Clips the segment [src,dst] in normalized camera coordinates against the
+ * rectangle with the Liang-Barsky algorithm. Returns false if the segment is
+ * outside of the rectangle, otherwise start and end of the part inside are
+ * written as ratios of the segment.
+ */
+static bool clipToRect(const cv::Point2d& src, const cv::Point2d& dst, const cv::Rect2d& rect, double* start_ratio,
+                       double* end_ratio)
+{
+  *start_ratio = 0;
+  *end_ratio = 1;
+  cv::Point2d diff = dst - src;
+  double p[4] = { -diff.x, diff.x, -diff.y, diff.y };
+  double q[4] = { src.x - rect.x, rect.x + rect.width - src.x, src.y - rect.y, rect.y + rect.height - src.y };
+  for (int idx = 0; idx < 4; idx++)
+  {
+    if (p[idx] == 0)
+    {
+      if (q[idx] < 0)
+      {
+        return false;
+      }
+      continue;
+    }
+    double ratio = q[idx] / p[idx];
+    if (p[idx] < 0)
+    {
+      *start_ratio = std::max(*start_ratio, ratio);
+    }
+    else
+    {
+      *end_ratio = std::min(*end_ratio, ratio);
+    }
+  }
+  return *start_ratio <= *end_ratio;
+}
+
+/**
+ * Maximal distance to the image of the extremities of drawn segments [px]
+ */
+static const double max_drawing_coordinate = 1e6;
+
+static bool isDrawable(const cv::Point2f& p)
+{
+  return std::fabs(p.x) < max_drawing_coordinate && std::fabs(p.y) < max_drawing_coordinate;
+}
+
 Field::Field()
 {
   ball_radius = 0.075;
@@ -202,48 +287,137 @@ void Field::updatePenaltyMarks()
 }
 
 void Field::tagLines(const CameraMetaInformation& camera_information, cv::Mat* tag_img, const cv::Scalar& line_color,
-                     double line_thickness, int nb_segments)
+                     double line_thickness, int nb_segments) const
+{
+  tagLines(CameraModel(camera_information), tag_img, line_color, line_thickness, nb_segments);
+}
+
+void Field::tagLines(const CameraModel& camera_model, cv::Mat* tag_img, const cv::Scalar& line_color,
+                     double line_thickness, int nb_segments) const
 {
-  if (!camera_information.has_camera_parameters() || !camera_information.has_pose())
+  if (!camera_model.isFullySpecified())
   {
     throw std::runtime_error(HL_DEBUG + " camera_information is not fully specified");
   }
-  cv::Mat camera_matrix, distortion_coefficients, rvec, tvec;
-  cv::Size size;
-  intrinsicToCV(camera_information.camera_parameters(), &camera_matrix, &distortion_coefficients, &size);
-  pose3DToCV(camera_information.pose(), &rvec, &tvec);
+  const cv::Size& size = camera_model.getImgSize();
   if (size.width != tag_img->cols || size.height != tag_img->rows)
   {
     std::ostringstream oss;
     oss << HL_DEBUG << " size mismatch " << size << " != " << tag_img->size;
     throw std::runtime_error(oss.str());
   }
-  tagLines(camera_matrix, distortion_coefficients, rvec, tvec, tag_img, line_color, line_thickness, nb_segments);
-}
+  const cv::Matx33d& rotation = camera_model.getRotation();
+  const cv::Mat& tvec = camera_model.getTVec();
+  cv::Vec3d translation(tvec.at<double>(0, 0), tvec.at<double>(1, 0), tvec.at<double>(2, 0));
+  const cv::Mat& camera_matrix = camera_model.getCameraMatrix();
+  double focal_x = camera_matrix.at<double>(0, 0);
+  double focal_y = camera_matrix.at<double>(1, 1);
+  double center_x = camera_matrix.at<double>(0, 2);
+  double center_y = camera_matrix.at<double>(1, 2);
+  const cv::Mat& distortion_coeffs = camera_model.getDistortionCoefficients();
+  bool has_distortion = !distortion_coeffs.empty() && cv::countNonZero(distortion_coeffs) > 0;
+  // Lines are clipped to three times the image in normalized coordinates: the distortion model is not reliable
+  // further away and projected points remain small enough for fixed-point drawing
+  cv::Rect2d valid_area((-size.width - center_x) / focal_x, (-size.height - center_y) / focal_y,
+                        3 * size.width / focal_x, 3 * size.height / focal_y);
 
-void Field::tagLines(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
-                     const cv::Mat& tvec, cv::Mat* tag_img, const cv::Scalar& line_color, double line_thickness,
-                     int nb_segments)
-{
+  // Clipping lines against the near plane and tessellating them
+  std::vector<cv::Point3f> object_points;
+  std::vector<size_t> lines_end;
   for (const auto& segment : getWhiteLines())
   {
+    cv::Vec3d src(segment.first.x, segment.first.y, segment.first.z);
+    cv::Vec3d dst(segment.second.x, segment.second.y, segment.second.z);
+    cv::Vec3d src_in_camera = rotation * src + translation;
+    cv::Vec3d dst_in_camera = rotation * dst + translation;
+    double start_ratio, end_ratio;
+    if (!clipToNearPlane(src_in_camera[2], dst_in_camera[2], &start_ratio, &end_ratio))
+    {
+      continue;
+    }
+    cv::Vec3d diff_in_camera = dst_in_camera - src_in_camera;
+    cv::Vec3d start_in_camera = src_in_camera + start_ratio * diff_in_camera;
+    cv::Vec3d end_in_camera = src_in_camera + end_ratio * diff_in_camera;
+    // Perspective preserves lines: the visible part is clipped in normalized coordinates and the ratios are
+    // converted back to the segment in the camera basis
+    cv::Point2d start_normalized(start_in_camera[0] / start_in_camera[2], start_in_camera[1] / start_in_camera[2]);
+    cv::Point2d end_normalized(end_in_camera[0] / end_in_camera[2], end_in_camera[1] / end_in_camera[2]);
+    double start_clip, end_clip;
+    if (!clipToRect(start_normalized, end_normalized, valid_area, &start_clip, &end_clip))
+    {
+      continue;
+    }
+    double start_depth = start_in_camera[2];
+    double end_depth = end_in_camera[2];
+    auto toCameraRatio = [start_depth, end_depth](double normalized_ratio) {
+      return normalized_ratio * start_depth / (normalized_ratio * start_depth + (1 - normalized_ratio) * end_depth);
+    };
+    double visible_start = start_ratio + (end_ratio - start_ratio) * toCameraRatio(start_clip);
+    double visible_end = start_ratio + (end_ratio - start_ratio) * toCameraRatio(end_clip);
+    start_ratio = visible_start;
+    end_ratio = visible_end;
+    cv::Point2d normalized_diff = end_normalized - start_normalized;
+    start_normalized += start_clip * normalized_diff;
+    end_normalized = start_normalized + (end_clip - start_clip) * normalized_diff;
+    int line_segments = 1;
+    if (has_distortion)
+    {
+      // Distortion bends the lines: the number of segments depends on the length of the line in the image
+      double dx = focal_x * (end_normalized.x - start_normalized.x);
+      double dy = focal_y * (end_normalized.y - start_normalized.y);
+      int adaptive_segments = std::ceil(std::sqrt(dx * dx + dy * dy) / max_segment_length_px);
+      line_segments = std::min(max_segments_per_line, std::max(nb_segments, adaptive_segments));
+    }
     cv::Point3f object_diff = segment.second - segment.first;
-    for (int i = 0; i < nb_segments; i++)
+    for (int i = 0; i <= line_segments; i++)
     {
-      std::vector<cv::Point3f> object_points = { segment.first + i * object_diff / nb_segments,
-                                                 segment.first + (i + 1) * object_diff / nb_segments };
-      std::vector<cv::Point2f> img_points;
-      cv::projectPoints(object_points, rvec, tvec, camera_matrix, distortion_coeffs, img_points);
-      // When point is outside of image, screw up the drawing
-      cv::Rect img_rect(cv::Point(), tag_img->size());
-      if (img_rect.contains(img_points[0]) && img_rect.contains(img_points[1]))
+      double ratio = start_ratio + (end_ratio - start_ratio) * i / line_segments;
+      object_points.push_back(segment.first + ratio * object_diff);
+    }
+    lines_end.push_back(object_points.size());
+  }
+
+  // Projecting all points at once
+  std::vector<cv::Point2f> img_points;
+  camera_model.fieldToImg(object_points, &img_points);
+
+  // Lines are drawn with sub-pixel accuracy
+  int shift = 4;
+  double scale = 1 << shift;
+  cv::Size scaled_size(size.width * scale, size.height * scale);
+  size_t line_start = 0;
+  for (size_t line_end : lines_end)
+  {
+    for (size_t idx = line_start; idx + 1 < line_end; idx++)
+    {
+      const cv::Point2f& src = img_points[idx];
+      const cv::Point2f& dst = img_points[idx + 1];
+      // Only reached with degenerate distortion models, avoids overflows of the fixed-point coordinates
+      if (!isDrawable(src) || !isDrawable(dst))
       {
-        cv::line(*tag_img, img_points[0], img_points[1], line_color, line_thickness);
+        continue;
+      }
+      cv::Point scaled_src(cvRound(src.x * scale), cvRound(src.y * scale));
+      cv::Point scaled_dst(cvRound(dst.x * scale), cvRound(dst.y * scale));
+      if (cv::clipLine(scaled_size, scaled_src, scaled_dst))
+      {
+        cv::line(*tag_img, scaled_src, scaled_dst, line_color, line_thickness, cv::LINE_8, shift);
       }
     }
+    line_start = line_end;
   }
 }
 
+void Field::tagLines(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
+                     const cv::Mat& tvec, cv::Mat* tag_img, const cv::Scalar& line_color, double line_thickness,
+                     int nb_segments) const
+{
+  CameraMetaInformation camera_meta;
+  cvToIntrinsic(camera_matrix, distortion_coeffs, tag_img->size(), camera_meta.mutable_camera_parameters());
+  cvToPose3D(rvec, tvec, camera_meta.mutable_pose());
+  tagLines(CameraModel(camera_meta), tag_img, line_color, line_thickness, nb_segments);
+}
+
 double Field::getArenaLength() const
 {
   return field_length + 2 * border_strip_width_x;
@@ -0,0 +1,57 @@
+#include "hl_monitoring/field_overlay_cache.h"
+
+#include <hl_communication/utils.h>
+
+namespace hl_monitoring
+{
+FieldOverlayCache::FieldOverlayCache()
+{
+}
+
+void FieldOverlayCache::tagLines(const std::string& camera_name, const Field& field,
+                                 const std::shared_ptr<const CameraModel>& camera_model, cv::Mat* img,
+                                 const cv::Scalar& line_color, double line_thickness, int nb_segments)
+{
+  if (!camera_model)
+  {
+    throw std::logic_error(HL_DEBUG + " no camera model provided for '" + camera_name + "'");
+  }
+  Overlay& overlay = overlays[camera_name];
+  if (!isUpToDate(overlay, field, camera_model, line_thickness, nb_segments))
+  {
+    overlay.camera_model = camera_model;
+    overlay.white_lines = field.getWhiteLines();
+    overlay.line_thickness = line_thickness;
+    overlay.nb_segments = nb_segments;
+    overlay.mask = cv::Mat::zeros(img->size(), CV_8UC1);
+    field.tagLines(*camera_model, &overlay.mask, cv::Scalar(255), line_thickness, nb_segments);
+  }
+  // Color is not part of the rendering: a single mask serves all colors
+  img->setTo(line_color, overlay.mask);
+}
+
+void FieldOverlayCache::clear()
+{
+  overlays.clear();
+}
+
+bool FieldOverlayCache::isUpToDate(const Overlay& overlay, const Field& field,
+                                   const std::shared_ptr<const CameraModel>& camera_model, double line_thickness,
+                                   int nb_segments)
+{
+  if (!overlay.camera_model || overlay.line_thickness != line_thickness || overlay.nb_segments != nb_segments ||
+      overlay.white_lines != field.getWhiteLines())
+  {
+    return false;
+  }
+  // Providers share models among frames: comparing parameters is rarely required
+  if (overlay.camera_model == camera_model)
+  {
+    return true;
+  }
+  const CameraMetaInformation& camera_meta = camera_model->getCameraInformation();
+  return overlay.camera_model->matches(camera_meta.has_camera_parameters() ? &camera_meta.camera_parameters() : nullptr,
+                                       camera_meta.has_pose() ? &camera_meta.pose() : nullptr);
+}
+
+}  // namespace hl_monitoring
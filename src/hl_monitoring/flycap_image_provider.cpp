@@ -22,8 +22,9 @@ PtGreyConnectionException::PtGreyConnectionException(const std::string& msg) : s
 {
 }
 
-FlyCapImageProvider::FlyCapImageProvider(const Json::Value& v, const std::string& output_prefix_)
-  : output_prefix(output_prefix_)
+FlyCapImageProvider::FlyCapImageProvider(const Json::Value& v, const std::string& output_prefix_,
+                                         const EncoderSettings& encoder_settings_)
+  : output_prefix(output_prefix_), encoder_settings(encoder_settings_)
 {
   readVal(v, "frame_rate", &frame_rate);
   readVal(v, "shutter", &shutter);
@@ -125,11 +126,7 @@ void FlyCapImageProvider::openOutputStream(const std::string& output_path)
   }
   bool use_color = true;
   std::cout << "Opening video_stream of size: " << img_size << std::endl;
-  output.open(output_path, cv::VideoWriter::fourcc('X', 'V', 'I', 'D'), frame_rate, img_size, use_color);
-  if (!output.isOpened())
-  {
-    throw std::runtime_error(HL_DEBUG + "Failed to open video at '" + output_path + "'");
-  }
+  encoder_settings.open(output_path, frame_rate, img_size, use_color, &output);
 }
 
 void FlyCapImageProvider::restartStream()
@@ -137,6 +134,16 @@ void FlyCapImageProvider::restartStream()
   throw std::logic_error("It makes no sense to restart the stream in a 'FlyCapImageProvider'");
 }
 
+void FlyCapImageProvider::enableReplayBuffer(double duration, int jpeg_quality)
+{
+  replay_buffer.reset(new ReplayBuffer(duration, jpeg_quality));
+}
+
+const ReplayBuffer* FlyCapImageProvider::getReplayBuffer() const
+{
+  return replay_buffer.get();
+}
+
 CalibratedImage FlyCapImageProvider::getCalibratedImage(uint64_t time_stamp)
 {
   if (nb_frames == 0)
@@ -145,28 +152,33 @@ CalibratedImage FlyCapImageProvider::getCalibratedImage(uint64_t time_stamp)
   }
   if (time_stamp < indices_by_time_stamp.rbegin()->first)
   {
-    throw std::runtime_error(HL_DEBUG + " asking for frames in the past is not supported");
+    if (!replay_buffer)
+    {
+      throw std::runtime_error(HL_DEBUG + " asking for frames in the past requires a replay buffer");
+    }
+    cv::Mat past_img;
+    uint64_t frame_time_stamp;
+    if (!replay_buffer->getImage(time_stamp, &past_img, &frame_time_stamp))
+    {
+      // Frame left the window of the buffer
+      return CalibratedImage();
+    }
+    int frame_index = indices_by_time_stamp.at(frame_time_stamp);
+    return CalibratedImage(past_img, getCameraModel(&meta_information.frames(frame_index)));
   }
 
   int index = indices_by_time_stamp.size() - 1;
 
-  CameraMetaInformation camera_meta;
-  if (meta_information.has_camera_parameters())
-  {
-    camera_meta.mutable_camera_parameters()->CopyFrom(meta_information.camera_parameters());
-  }
+  return CalibratedImage(img, getCameraModel(&meta_information.frames(index)));
+}
 
-  const FrameEntry& frame = meta_information.frames(index);
-  if (frame.has_pose())
-  {
-    camera_meta.mutable_pose()->CopyFrom(frame.pose());
-  }
-  else if (meta_information.has_default_pose())
+uint64_t FlyCapImageProvider::getStart() const
+{
+  if (replay_buffer && replay_buffer->size() > 0)
   {
-    camera_meta.mutable_pose()->CopyFrom(meta_information.default_pose());
+    return replay_buffer->getStart();
   }
-
-  return CalibratedImage(img, camera_meta);
+  return getEnd();
 }
 
 void FlyCapImageProvider::update()
@@ -217,7 +229,7 @@ cv::Mat FlyCapImageProvider::getNextImg()
   if (output_prefix != "" && !output.isOpened())
   {
     img_size = img.size();
-    openOutputStream(output_prefix + ".avi");
+    openOutputStream(encoder_settings.getPath(output_prefix));
   }
   // Write image to output video if opened
   if (output.isOpened())
@@ -230,6 +242,10 @@ cv::Mat FlyCapImageProvider::getNextImg()
     }
     output.write(img);
   }
+  if (replay_buffer)
+  {
+    replay_buffer->push(time_stamp, img);
+  }
   return img;
 }
 
@@ -0,0 +1,317 @@
+#include "hl_monitoring/frame_index.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/meta_information_reader.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hl_monitoring
+{
+static size_t alignFrameIndex(size_t size)
+{
+  return (size + 7) / 8 * 8;
+}
+
+/**
+ * Read size [bytes] and modification time [ns] of the file
+ */
+static void getFileStamp(const std::string& path, uint64_t* size, int64_t* mtime)
+{
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to stat '" + path + "': " + strerror(errno));
+  }
+  *size = file_stat.st_size;
+  *mtime = (int64_t)file_stat.st_mtim.tv_sec * 1000 * 1000 * 1000 + file_stat.st_mtim.tv_nsec;
+}
+
+/**
+ * Write the content in a temporary file which is then renamed, concurrent
+ * readers never see a partial index. Returns false on failure.
+ */
+static bool writeAtomically(const std::string& path, const std::string& content)
+{
+  std::string tmp_path = path + ".XXXXXX";
+  int fd = mkstemp(&tmp_path[0]);
+  if (fd < 0)
+  {
+    return false;
+  }
+  size_t written = 0;
+  while (written < content.size())
+  {
+    ssize_t result = write(fd, content.data() + written, content.size() - written);
+    if (result <= 0)
+    {
+      break;
+    }
+    written += result;
+  }
+  bool success = written == content.size() && fchmod(fd, 0644) == 0;
+  success = close(fd) == 0 && success;
+  success = success && rename(tmp_path.c_str(), path.c_str()) == 0;
+  if (!success)
+  {
+    unlink(tmp_path.c_str());
+  }
+  return success;
+}
+
+FrameIndex::FrameIndex() : mapping(nullptr), mapping_size(0), header(nullptr), records(nullptr), content_size(0)
+{
+}
+
+FrameIndex::~FrameIndex()
+{
+  close();
+}
+
+std::string FrameIndex::getIndexPath(const std::string& meta_path)
+{
+  return meta_path + ".idx";
+}
+
+std::string FrameIndex::build(const std::string& meta_path)
+{
+  FrameIndexHeader index_header;
+  index_header.magic = frame_index_magic;
+  index_header.version = frame_index_version;
+  getFileStamp(meta_path, &index_header.meta_size, &index_header.meta_mtime);
+  index_header.reserved = 0;
+
+  MetaInformationReader reader(meta_path);
+  std::string header_data;
+  if (!reader.getHeader().SerializeToString(&header_data))
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to serialize header of '" + meta_path + "'");
+  }
+  std::vector<FrameIndexRecord> frame_records;
+  std::vector<FrameIndexPose> poses;
+  frame_records.reserve(reader.getNbFrames());
+  FrameEntry frame;
+  for (uint32_t frame_number = 0; reader.readNextFrame(&frame); frame_number++)
+  {
+    FrameIndexRecord record = { frame.time_stamp(), frame_number, 0, 0 };
+    if (frame.has_pose())
+    {
+      const Pose3D& pose = frame.pose();
+      if (pose.rotation_size() != 3 || pose.translation_size() != 3)
+      {
+        throw std::runtime_error(HL_DEBUG + "Invalid pose for frame " + std::to_string(frame_number) + " in '" +
+                                 meta_path + "'");
+      }
+      FrameIndexPose index_pose;
+      for (int dim = 0; dim < 3; dim++)
+      {
+        index_pose.rotation[dim] = pose.rotation(dim);
+        index_pose.translation[dim] = pose.translation(dim);
+      }
+      record.flags |= frame_index_has_pose;
+      // Temporarily stores the index of the pose, converted to an offset once sizes are known
+      record.pose_offset = poses.size();
+      poses.push_back(index_pose);
+    }
+    frame_records.push_back(record);
+  }
+  auto compare_time_stamps = [](const FrameIndexRecord& r1, const FrameIndexRecord& r2) {
+    return r1.time_stamp < r2.time_stamp;
+  };
+  std::stable_sort(frame_records.begin(), frame_records.end(), compare_time_stamps);
+  for (size_t idx = 1; idx < frame_records.size(); idx++)
+  {
+    if (frame_records[idx].time_stamp == frame_records[idx - 1].time_stamp)
+    {
+      throw std::runtime_error(HL_DEBUG + "Duplicated time_stamp " + std::to_string(frame_records[idx].time_stamp) +
+                               " in '" + meta_path + "'");
+    }
+  }
+
+  index_header.nb_frames = frame_records.size();
+  index_header.nb_poses = poses.size();
+  index_header.header_size = header_data.size();
+  size_t records_offset = alignFrameIndex(sizeof(FrameIndexHeader) + header_data.size());
+  size_t poses_offset = records_offset + frame_records.size() * sizeof(FrameIndexRecord);
+  for (FrameIndexRecord& record : frame_records)
+  {
+    if (record.flags & frame_index_has_pose)
+    {
+      record.pose_offset = poses_offset + record.pose_offset * sizeof(FrameIndexPose);
+    }
+  }
+  std::string content(poses_offset + poses.size() * sizeof(FrameIndexPose), '\0');
+  memcpy(&content[0], &index_header, sizeof(FrameIndexHeader));
+  memcpy(&content[sizeof(FrameIndexHeader)], header_data.data(), header_data.size());
+  memcpy(&content[records_offset], frame_records.data(), frame_records.size() * sizeof(FrameIndexRecord));
+  memcpy(&content[poses_offset], poses.data(), poses.size() * sizeof(FrameIndexPose));
+  return content;
+}
+
+void FrameIndex::open(const std::string& meta_path)
+{
+  close();
+  uint64_t meta_size;
+  int64_t meta_mtime;
+  getFileStamp(meta_path, &meta_size, &meta_mtime);
+  std::string index_path = getIndexPath(meta_path);
+  if (map(index_path, meta_size, meta_mtime))
+  {
+    return;
+  }
+  std::string content = build(meta_path);
+  if (writeAtomically(index_path, content) && map(index_path, meta_size, meta_mtime))
+  {
+    return;
+  }
+  std::cerr << "Failed to write frame index '" << index_path << "': keeping it in memory" << std::endl;
+  memory.swap(content);
+  if (!setContent((const uint8_t*)memory.data(), memory.size()))
+  {
+    throw std::logic_error(HL_DEBUG + "inconsistent index built for '" + meta_path + "'");
+  }
+}
+
+void FrameIndex::close()
+{
+  if (mapping != nullptr)
+  {
+    munmap(mapping, mapping_size);
+  }
+  mapping = nullptr;
+  mapping_size = 0;
+  memory.clear();
+  header = nullptr;
+  records = nullptr;
+  content_size = 0;
+  meta_header.Clear();
+}
+
+bool FrameIndex::isOpen() const
+{
+  return header != nullptr;
+}
+
+const VideoMetaInformation& FrameIndex::getHeader() const
+{
+  return meta_header;
+}
+
+size_t FrameIndex::size() const
+{
+  return header == nullptr ? 0 : header->nb_frames;
+}
+
+const FrameIndexRecord& FrameIndex::getRecord(size_t idx) const
+{
+  if (idx >= size())
+  {
+    throw std::out_of_range(HL_DEBUG + "invalid record " + std::to_string(idx) + "/" + std::to_string(size()));
+  }
+  return records[idx];
+}
+
+int FrameIndex::find(uint64_t time_stamp) const
+{
+  const FrameIndexRecord* end = records + size();
+  auto is_before = [](uint64_t time_stamp, const FrameIndexRecord& record) { return time_stamp < record.time_stamp; };
+  const FrameIndexRecord* it = std::upper_bound(records, end, time_stamp, is_before);
+  return (int)(it - records) - 1;
+}
+
+bool FrameIndex::getPose(const FrameIndexRecord& record, Pose3D* pose) const
+{
+  if (!(record.flags & frame_index_has_pose))
+  {
+    return false;
+  }
+  if (record.pose_offset + sizeof(FrameIndexPose) > content_size)
+  {
+    throw std::runtime_error(HL_DEBUG + "invalid pose offset in frame index");
+  }
+  const uint8_t* data = (const uint8_t*)header;
+  const FrameIndexPose* index_pose = (const FrameIndexPose*)(data + record.pose_offset);
+  pose->Clear();
+  for (int dim = 0; dim < 3; dim++)
+  {
+    pose->add_rotation(index_pose->rotation[dim]);
+    pose->add_translation(index_pose->translation[dim]);
+  }
+  return true;
+}
+
+uint64_t FrameIndex::getStart() const
+{
+  return size() == 0 ? 0 : records[0].time_stamp;
+}
+
+uint64_t FrameIndex::getEnd() const
+{
+  return size() == 0 ? 0 : records[size() - 1].time_stamp;
+}
+
+bool FrameIndex::map(const std::string& index_path, uint64_t meta_size, int64_t meta_mtime)
+{
+  int fd = ::open(index_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat index_stat;
+  if (fstat(fd, &index_stat) != 0 || (size_t)index_stat.st_size < sizeof(FrameIndexHeader))
+  {
+    ::close(fd);
+    return false;
+  }
+  size_t data_size = index_stat.st_size;
+  void* ptr = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping remains valid once the file descriptor is closed
+  ::close(fd);
+  if (ptr == MAP_FAILED)
+  {
+    return false;
+  }
+  const FrameIndexHeader* index_header = (const FrameIndexHeader*)ptr;
+  if (index_header->meta_size != meta_size || index_header->meta_mtime != meta_mtime ||
+      !setContent((const uint8_t*)ptr, data_size))
+  {
+    munmap(ptr, data_size);
+    return false;
+  }
+  mapping = (uint8_t*)ptr;
+  mapping_size = data_size;
+  return true;
+}
+
+bool FrameIndex::setContent(const uint8_t* data, size_t data_size)
+{
+  const FrameIndexHeader* index_header = (const FrameIndexHeader*)data;
+  if (data_size < sizeof(FrameIndexHeader) || index_header->magic != frame_index_magic ||
+      index_header->version != frame_index_version)
+  {
+    return false;
+  }
+  size_t records_offset = alignFrameIndex(sizeof(FrameIndexHeader) + index_header->header_size);
+  size_t poses_offset = records_offset + index_header->nb_frames * sizeof(FrameIndexRecord);
+  if (poses_offset + index_header->nb_poses * sizeof(FrameIndexPose) != data_size ||
+      !meta_header.ParseFromArray(data + sizeof(FrameIndexHeader), index_header->header_size))
+  {
+    meta_header.Clear();
+    return false;
+  }
+  header = index_header;
+  records = (const FrameIndexRecord*)(data + records_offset);
+  content_size = data_size;
+  return true;
+}
+
+}  // namespace hl_monitoring
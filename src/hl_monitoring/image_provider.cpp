@@ -15,6 +15,22 @@ CalibratedImage ImageProvider::getCalibratedImage(uint64_t time_stamp, bool syst
   return getCalibratedImage(time_stamp);
 }
 
+void ImageProvider::getCalibratedImage(uint64_t time_stamp, CalibratedImage* out)
+{
+  *out = getCalibratedImage(time_stamp);
+}
+
+uint64_t ImageProvider::getFrameTimeStamp(uint64_t time_stamp) const
+{
+  auto it = indices_by_time_stamp.upper_bound(time_stamp);
+  if (it == indices_by_time_stamp.begin())
+  {
+    return 0;
+  }
+  it--;
+  return it->first;
+}
+
 uint64_t ImageProvider::getStart() const
 {
   if (indices_by_time_stamp.size() == 0)
@@ -34,6 +50,11 @@ size_t ImageProvider::getNbFrames() const
   return nb_frames;
 }
 
+const VideoMetaInformation& ImageProvider::getMetaInformation()
+{
+  return meta_information;
+}
+
 void ImageProvider::setIntrinsic(const IntrinsicParameters& params)
 {
   meta_information.mutable_camera_parameters()->CopyFrom(params);
@@ -44,11 +65,73 @@ void ImageProvider::setDefaultPose(const Pose3D& pose)
   meta_information.mutable_default_pose()->CopyFrom(pose);
 }
 
+void ImageProvider::addPoseSample(uint64_t time_stamp, const Pose3D& pose)
+{
+  pose_timeline.addSample(time_stamp, pose);
+}
+
 void ImageProvider::setOffset(int64 offset)
 {
   meta_information.set_time_offset(offset);
 }
 
+std::shared_ptr<const CameraModel> ImageProvider::getCameraModel(const FrameEntry* frame)
+{
+  const IntrinsicParameters* camera_parameters = nullptr;
+  if (meta_information.has_camera_parameters())
+  {
+    camera_parameters = &meta_information.camera_parameters();
+  }
+  bool use_frame_pose = frame != nullptr && frame->has_pose();
+  const Pose3D* pose = nullptr;
+  if (use_frame_pose)
+  {
+    pose = &frame->pose();
+  }
+  else if (frame != nullptr && pose_timeline.getPose(frame->time_stamp(), &interpolated_pose))
+  {
+    use_frame_pose = true;
+    pose = &interpolated_pose;
+  }
+  else if (meta_information.has_default_pose())
+  {
+    pose = &meta_information.default_pose();
+  }
+  std::shared_ptr<CameraModel>& model = use_frame_pose ? frame_camera_model : default_camera_model;
+  if (model && !model->matches(camera_parameters, pose) && model.use_count() == 1 && pose != nullptr &&
+      model->hasPose() && model->matches(camera_parameters, &model->getCameraInformation().pose()))
+  {
+    // Model is not used by any image anymore and only the pose changed
+    model->setPose(*pose);
+  }
+  else if (!model || !model->matches(camera_parameters, pose))
+  {
+    CameraMetaInformation camera_meta;
+    if (camera_parameters != nullptr)
+    {
+      camera_meta.mutable_camera_parameters()->CopyFrom(*camera_parameters);
+    }
+    if (pose != nullptr)
+    {
+      camera_meta.mutable_pose()->CopyFrom(*pose);
+    }
+    model = std::make_shared<CameraModel>(camera_meta);
+  }
+  return model;
+}
+
+void ImageProvider::updatePoseTimeline()
+{
+  pose_timeline.clear();
+  for (const FrameEntry& frame : meta_information.frames())
+  {
+    if (frame.has_pose())
+    {
+      pose_timeline.addSample(frame.time_stamp(), frame.pose());
+    }
+  }
+}
+
 int64 ImageProvider::getOffset() const
 {
   if (!meta_information.has_time_offset())
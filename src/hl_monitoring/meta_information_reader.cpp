@@ -0,0 +1,188 @@
+#include "hl_monitoring/meta_information_reader.h"
+
+#include <hl_communication/utils.h>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::FileInputStream;
+using google::protobuf::io::StringOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace hl_monitoring
+{
+MetaInformationReader::MetaInformationReader(const std::string& path_) : path(path_), fd(-1), nb_frames(0)
+{
+  fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open file '" + path + "'");
+  }
+  try
+  {
+    scan();
+  }
+  catch (...)
+  {
+    close(fd);
+    throw;
+  }
+  restart();
+}
+
+MetaInformationReader::~MetaInformationReader()
+{
+  input.reset();
+  close(fd);
+}
+
+const std::string& MetaInformationReader::getPath() const
+{
+  return path;
+}
+
+const VideoMetaInformation& MetaInformationReader::getHeader() const
+{
+  return header;
+}
+
+int MetaInformationReader::getNbFrames() const
+{
+  return nb_frames;
+}
+
+const FrameEntry& MetaInformationReader::getFirstFrame() const
+{
+  if (nb_frames == 0)
+  {
+    throw std::out_of_range(HL_DEBUG + "no frames in '" + path + "'");
+  }
+  return first_frame;
+}
+
+const FrameEntry& MetaInformationReader::getLastFrame() const
+{
+  if (nb_frames == 0)
+  {
+    throw std::out_of_range(HL_DEBUG + "no frames in '" + path + "'");
+  }
+  return last_frame;
+}
+
+void MetaInformationReader::restart()
+{
+  openStream(0);
+}
+
+bool MetaInformationReader::readNextFrame(FrameEntry* frame)
+{
+  // A new CodedInputStream is used for each frame, this avoids reaching the
+  // total bytes limit on large files. Unread data is given back to 'input' on
+  // destruction
+  CodedInputStream coded_input(input.get());
+  uint32_t tag;
+  while ((tag = coded_input.ReadTag()) != 0)
+  {
+    if (WireFormatLite::GetTagFieldNumber(tag) != VideoMetaInformation::kFramesFieldNumber)
+    {
+      if (!WireFormatLite::SkipField(&coded_input, tag))
+      {
+        throw std::runtime_error(HL_DEBUG + "Failed to skip field in '" + path + "'");
+      }
+      continue;
+    }
+    uint32_t length;
+    if (!coded_input.ReadVarint32(&length))
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to read frame length in '" + path + "'");
+    }
+    CodedInputStream::Limit limit = coded_input.PushLimit(length);
+    if (!frame->ParseFromCodedStream(&coded_input) || !coded_input.ConsumedEntireMessage())
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to parse frame in '" + path + "'");
+    }
+    coded_input.PopLimit(limit);
+    return true;
+  }
+  return false;
+}
+
+void MetaInformationReader::openStream(int64_t offset)
+{
+  input.reset();
+  if (lseek(fd, offset, SEEK_SET) != offset)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to seek in '" + path + "'");
+  }
+  input.reset(new FileInputStream(fd));
+}
+
+void MetaInformationReader::scan()
+{
+  openStream(0);
+  std::string header_data;
+  int64_t last_frame_offset = -1;
+  {
+    StringOutputStream header_stream(&header_data);
+    CodedOutputStream header_output(&header_stream);
+    while (true)
+    {
+      int64_t tag_offset = input->ByteCount();
+      CodedInputStream coded_input(input.get());
+      uint32_t tag = coded_input.ReadTag();
+      if (tag == 0)
+      {
+        break;
+      }
+      if (WireFormatLite::GetTagFieldNumber(tag) != VideoMetaInformation::kFramesFieldNumber)
+      {
+        // Content of the header is copied to be parsed at the end
+        if (!WireFormatLite::SkipField(&coded_input, tag, &header_output))
+        {
+          throw std::runtime_error(HL_DEBUG + "Failed to read header field in '" + path + "'");
+        }
+        continue;
+      }
+      uint32_t length;
+      if (!coded_input.ReadVarint32(&length))
+      {
+        throw std::runtime_error(HL_DEBUG + "Failed to read frame length in '" + path + "'");
+      }
+      if (nb_frames == 0)
+      {
+        CodedInputStream::Limit limit = coded_input.PushLimit(length);
+        if (!first_frame.ParseFromCodedStream(&coded_input) || !coded_input.ConsumedEntireMessage())
+        {
+          throw std::runtime_error(HL_DEBUG + "Failed to parse frame in '" + path + "'");
+        }
+        coded_input.PopLimit(limit);
+      }
+      else if (!coded_input.Skip(length))
+      {
+        throw std::runtime_error(HL_DEBUG + "Truncated frame in '" + path + "'");
+      }
+      last_frame_offset = tag_offset;
+      nb_frames++;
+    }
+  }
+  if (!header.ParseFromString(header_data))
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to parse header of '" + path + "'");
+  }
+  if (nb_frames > 0)
+  {
+    openStream(last_frame_offset);
+    if (!readNextFrame(&last_frame))
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to read last frame of '" + path + "'");
+    }
+  }
+}
+
+}  // namespace hl_monitoring
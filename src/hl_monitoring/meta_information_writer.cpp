@@ -0,0 +1,95 @@
+#include "hl_monitoring/meta_information_writer.h"
+
+#include <hl_communication/utils.h>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <fcntl.h>
+
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::FileOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace hl_monitoring
+{
+MetaInformationWriter::MetaInformationWriter(const std::string& path_) : path(path_), nb_frames(0)
+{
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open file '" + path + "'");
+  }
+  output.reset(new FileOutputStream(fd));
+}
+
+MetaInformationWriter::~MetaInformationWriter()
+{
+  if (output)
+  {
+    // Errors cannot be reported from destructor, close() should be used
+    output->Close();
+  }
+}
+
+const std::string& MetaInformationWriter::getPath() const
+{
+  return path;
+}
+
+void MetaInformationWriter::writeHeader(const VideoMetaInformation& header)
+{
+  checkOpen();
+  if (!header.SerializeToZeroCopyStream(output.get()))
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to write header in '" + path + "'");
+  }
+}
+
+void MetaInformationWriter::writeFrame(const FrameEntry& frame)
+{
+  checkOpen();
+  if (!frame.IsInitialized())
+  {
+    throw std::logic_error(HL_DEBUG + "Incomplete frame: " + frame.InitializationErrorString());
+  }
+  // Unused buffer is given back to 'output' on destruction
+  CodedOutputStream coded_output(output.get());
+  // ByteSize also caches the size required by SerializeWithCachedSizes
+  int size = frame.ByteSize();
+  coded_output.WriteTag(
+      WireFormatLite::MakeTag(VideoMetaInformation::kFramesFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+  coded_output.WriteVarint32(size);
+  frame.SerializeWithCachedSizes(&coded_output);
+  if (coded_output.HadError())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to write frame in '" + path + "'");
+  }
+  nb_frames++;
+}
+
+int MetaInformationWriter::getNbFrames() const
+{
+  return nb_frames;
+}
+
+void MetaInformationWriter::close()
+{
+  checkOpen();
+  bool success = output->Close();
+  output.reset();
+  if (!success)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to close '" + path + "'");
+  }
+}
+
+void MetaInformationWriter::checkOpen() const
+{
+  if (!output)
+  {
+    throw std::logic_error(HL_DEBUG + "'" + path + "' has already been closed");
+  }
+}
+
+}  // namespace hl_monitoring
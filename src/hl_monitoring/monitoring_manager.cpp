@@ -3,9 +3,11 @@
 #include <hl_communication/utils.h>
 #include <hl_monitoring/opencv_image_provider.h>
 #include <hl_monitoring/replay_image_provider.h>
+#include <hl_monitoring/shared_memory_image_provider.h>
 #include <hl_monitoring/utils.h>
 
 #include <fstream>
+#include <future>
 
 #ifdef HL_MONITORING_USES_FLYCAPTURE
 #include <hl_monitoring/flycap_image_provider.h>
@@ -15,7 +17,7 @@ using namespace hl_communication;
 
 namespace hl_monitoring
 {
-MonitoringManager::MonitoringManager()
+MonitoringManager::MonitoringManager() : live(false), last_clock_sample(0), clock_sampling_period(100 * 1000)
 {
 }
 
@@ -48,6 +50,13 @@ void MonitoringManager::loadConfig(const std::string& path)
   loadMessageManager(root["message_manager"]);
   readVal(root, "live", &live);
   tryReadVal(root, "msg_collection_path", &msg_collection_path);
+  int clock_sampling_ms = clock_sampling_period / 1000;
+  tryReadVal(root, "clock_sampling_ms", &clock_sampling_ms);
+  if (clock_sampling_ms <= 0)
+  {
+    throw std::runtime_error(HL_DEBUG + " clock_sampling_ms should be strictly positive");
+  }
+  clock_sampling_period = clock_sampling_ms * 1000;
 }
 
 std::unique_ptr<ImageProvider> MonitoringManager::buildImageProvider(const Json::Value& v)
@@ -55,6 +64,19 @@ std::unique_ptr<ImageProvider> MonitoringManager::buildImageProvider(const Json:
   checkMember(v, "class_name");
   std::unique_ptr<ImageProvider> result;
   std::string class_name, input_path, intrinsic_path, default_pose_path;
+  EncoderSettings encoder_settings;
+  if (v.isMember("encoder"))
+  {
+    encoder_settings.fromJson(v["encoder"]);
+  }
+  // Duration [s] of the replay buffer of live providers, disabled if 0
+  double replay_duration = 0;
+  int replay_quality = 85;
+  if (v.isMember("replay_buffer"))
+  {
+    readVal(v["replay_buffer"], "duration", &replay_duration);
+    tryReadVal(v["replay_buffer"], "quality", &replay_quality);
+  }
   readVal(v, "class_name", &class_name);
   tryReadVal(v, "intrinsic_path", &intrinsic_path);
   tryReadVal(v, "default_pose_path", &default_pose_path);
@@ -63,13 +85,19 @@ std::unique_ptr<ImageProvider> MonitoringManager::buildImageProvider(const Json:
     checkMember(v, "input_path");
     readVal(v, "input_path", &input_path);
     std::string output_prefix;
+    OpenCVImageProvider* provider;
     if (v.isMember("output_prefix"))
     {
-      result.reset(new OpenCVImageProvider(input_path, v["output_prefix"].asString()));
+      provider = new OpenCVImageProvider(input_path, v["output_prefix"].asString(), encoder_settings);
     }
     else
     {
-      result.reset(new OpenCVImageProvider(input_path));
+      provider = new OpenCVImageProvider(input_path);
+    }
+    result.reset(provider);
+    if (replay_duration > 0)
+    {
+      provider->enableReplayBuffer(replay_duration, replay_quality);
     }
   }
   else if (class_name == "ReplayImageProvider")
@@ -86,19 +114,31 @@ std::unique_ptr<ImageProvider> MonitoringManager::buildImageProvider(const Json:
       result.reset(new ReplayImageProvider(input_path));
     }
   }
+  else if (class_name == "SharedMemoryImageProvider")
+  {
+    std::string bus_name;
+    readVal(v, "bus_name", &bus_name);
+    result.reset(new SharedMemoryImageProvider(bus_name));
+  }
 #ifdef HL_MONITORING_USES_FLYCAPTURE
   else if (class_name == "FlyCapImageProvider")
   {
     checkMember(v, "parameters");
     const Json::Value& parameters = v["parameters"];
     std::string output_prefix;
+    FlyCapImageProvider* provider;
     if (v.isMember("output_prefix"))
     {
-      result.reset(new FlyCapImageProvider(parameters, v["output_prefix"].asString()));
+      provider = new FlyCapImageProvider(parameters, v["output_prefix"].asString(), encoder_settings);
     }
     else
     {
-      result.reset(new FlyCapImageProvider(parameters));
+      provider = new FlyCapImageProvider(parameters);
+    }
+    result.reset(provider);
+    if (replay_duration > 0)
+    {
+      provider->enableReplayBuffer(replay_duration, replay_quality);
     }
   }
 #endif
@@ -127,10 +167,18 @@ void MonitoringManager::loadImageProviders(const Json::Value& v)
   {
     throw std::runtime_error(HL_DEBUG + " invalid type for v, expecting an object");
   }
+  // Opening videos and devices is slow, providers are built in parallel. Captures and
+  // writers share the environment of the process, they are opened under lockVideoEnvironment
+  std::map<std::string, std::future<std::unique_ptr<ImageProvider>>> pending_providers;
   for (Json::ValueConstIterator it = v.begin(); it != v.end(); it++)
   {
     const std::string& key = it.name();
-    addImageProvider(key, buildImageProvider(v[key]));
+    pending_providers[key] =
+        std::async(std::launch::async, &MonitoringManager::buildImageProvider, this, std::cref(v[key]));
+  }
+  for (auto& entry : pending_providers)
+  {
+    addImageProvider(entry.first, entry.second.get());
   }
 }
 
@@ -170,17 +218,23 @@ void MonitoringManager::loadMessageManager(const Json::Value& v)
   }
   if (ports_set)
   {
-    message_manager.reset(new MessageManager(ports));
+    setMessageManager(std::unique_ptr<MessageManager>(new MessageManager(ports)));
   }
   else
   {
-    message_manager.reset(new MessageManager(file_path));
+    setMessageManager(std::unique_ptr<MessageManager>(new MessageManager(file_path)));
   }
 }
 
 void MonitoringManager::setMessageManager(std::unique_ptr<MessageManager> new_message_manager)
 {
+  // Cursor refers to the previous manager
+  status_cursor.reset();
   message_manager = std::move(new_message_manager);
+  if (message_manager)
+  {
+    status_cursor.reset(new StatusCursor(message_manager.get()));
+  }
 }
 
 void MonitoringManager::addImageProvider(const std::string& name, std::unique_ptr<ImageProvider> image_provider)
@@ -194,6 +248,10 @@ void MonitoringManager::addImageProvider(const std::string& name, std::unique_pt
 
 void MonitoringManager::update()
 {
+  if (live)
+  {
+    updateClockSynchronization();
+  }
   for (const auto& entry : image_providers)
   {
     entry.second->update();
@@ -204,19 +262,50 @@ void MonitoringManager::update()
 std::map<std::string, CalibratedImage> MonitoringManager::getCalibratedImages(uint64_t time_stamp)
 {
   std::map<std::string, CalibratedImage> images;
+  getCalibratedImages(time_stamp, &images);
+  return images;
+}
+
+void MonitoringManager::getCalibratedImages(uint64_t time_stamp, std::map<std::string, CalibratedImage>* images)
+{
+  // Removing entries which do not match any provider anymore
+  for (auto it = images->begin(); it != images->end();)
+  {
+    if (image_providers.count(it->first) == 0)
+    {
+      it = images->erase(it);
+    }
+    else
+    {
+      it++;
+    }
+  }
   for (const auto& entry : image_providers)
   {
     if (entry.second->getStart() <= time_stamp)
     {
-      images[entry.first] = entry.second->getCalibratedImage(time_stamp);
+      CalibratedImage* img = &(*images)[entry.first];
+      entry.second->getCalibratedImage(time_stamp, img);
+      // Frame might not be available anymore (e.g. out of the replay window of a live provider)
+      if (img->getImg().empty())
+      {
+        images->erase(entry.first);
+      }
+    }
+    else
+    {
+      images->erase(entry.first);
     }
   }
-  return images;
 }
 
-hl_communication::MessageManager::Status MonitoringManager::getStatus(uint64_t time_stamp)
+const MessageManager::Status& MonitoringManager::getStatus(uint64_t time_stamp)
 {
-  return message_manager->getStatus(time_stamp);
+  if (!status_cursor)
+  {
+    throw std::logic_error(HL_DEBUG + " no message manager available");
+  }
+  return status_cursor->getStatus(time_stamp);
 }
 
 const ImageProvider& MonitoringManager::getImageProvider(const std::string& name) const
@@ -303,14 +392,35 @@ int64 MonitoringManager::getOffset() const
     return 0;
   }
   int64_t sum_offset = 0;
-  int nb_offsets = 0;
   for (int64_t offset : offsets)
   {
     sum_offset += offset;
   }
   // TODO: add a mechanism to watch potential overflows on sum_offset;
-  int64_t mean_offset = sum_offset / nb_offsets;
+  int64_t mean_offset = sum_offset / (int64_t)offsets.size();
   return mean_offset;
 }
 
+const ClockSynchronizer& MonitoringManager::getClockSynchronizer() const
+{
+  return clock_synchronizer;
+}
+
+double MonitoringManager::getOffsetUncertainty() const
+{
+  return clock_synchronizer.getUncertainty();
+}
+
+void MonitoringManager::updateClockSynchronization()
+{
+  uint64_t now = getTimeStamp();
+  if (clock_synchronizer.hasEstimate() && now < last_clock_sample + clock_sampling_period)
+  {
+    return;
+  }
+  clock_synchronizer.sampleSystemClock();
+  last_clock_sample = now;
+  setOffset(clock_synchronizer.getOffset(now));
+}
+
 }  // namespace hl_monitoring
@@ -10,13 +10,14 @@ using namespace hl_communication;
 
 namespace hl_monitoring
 {
-OpenCVImageProvider::OpenCVImageProvider(const std::string& video_path, const std::string& output_prefix_)
-  : output_prefix(output_prefix_)
+OpenCVImageProvider::OpenCVImageProvider(const std::string& video_path, const std::string& output_prefix_,
+                                         const EncoderSettings& encoder_settings_)
+  : output_prefix(output_prefix_), encoder_settings(encoder_settings_)
 {
   openInputStream(video_path);
   if (output_prefix != "")
   {
-    openOutputStream(output_prefix + ".avi");
+    openOutputStream(encoder_settings.getPath(output_prefix));
   }
 }
 OpenCVImageProvider::~OpenCVImageProvider()
@@ -31,10 +32,12 @@ double OpenCVImageProvider::getFPS() const
 
 void OpenCVImageProvider::openInputStream(const std::string& video_path)
 {
+  std::unique_lock<std::mutex> lock = lockVideoEnvironment();
   if (!input.open(video_path))
   {
     throw std::runtime_error(HL_DEBUG + " failed to open device '" + video_path + "'");
   }
+  lock.unlock();
   int read_width = input.get(cv::CAP_PROP_FRAME_WIDTH);
   int read_height = input.get(cv::CAP_PROP_FRAME_HEIGHT);
   img_size = cv::Size(read_width, read_height);
@@ -61,11 +64,7 @@ void OpenCVImageProvider::openOutputStream(const std::string& output_path)
   }
   double fps = getFPS();
   bool use_color = true;
-  output.open(output_path, cv::VideoWriter::fourcc('X', 'V', 'I', 'D'), fps, img_size, use_color);
-  if (!output.isOpened())
-  {
-    throw std::runtime_error(HL_DEBUG + "Failed to open video");
-  }
+  encoder_settings.open(output_path, fps, img_size, use_color, &output);
 }
 
 void OpenCVImageProvider::restartStream()
@@ -73,36 +72,64 @@ void OpenCVImageProvider::restartStream()
   throw std::logic_error("It makes no sense to restart the stream in a 'OpenCVImageProvider'");
 }
 
+void OpenCVImageProvider::enableReplayBuffer(double duration, int jpeg_quality)
+{
+  replay_buffer.reset(new ReplayBuffer(duration, jpeg_quality));
+}
+
+const ReplayBuffer* OpenCVImageProvider::getReplayBuffer() const
+{
+  return replay_buffer.get();
+}
+
 CalibratedImage OpenCVImageProvider::getCalibratedImage(uint64_t time_stamp)
+{
+  CalibratedImage result;
+  getCalibratedImage(time_stamp, &result);
+  return result;
+}
+
+void OpenCVImageProvider::getCalibratedImage(uint64_t time_stamp, CalibratedImage* out)
 {
   if (nb_frames == 0)
   {
     throw std::runtime_error(HL_DEBUG + " no frames found in the stream");
   }
+  cv::Mat buffer = out->getImg();
+  // Releasing the previous model first allows to update it in place
+  out->clear();
   if (time_stamp < indices_by_time_stamp.rbegin()->first)
   {
-    throw std::runtime_error(HL_DEBUG + " asking for frames in the past is not supported");
+    if (!replay_buffer)
+    {
+      throw std::runtime_error(HL_DEBUG + " asking for frames in the past requires a replay buffer");
+    }
+    // Buffer of the stream or of images still used elsewhere cannot be overwritten
+    if (buffer.data == img.data || (buffer.u != nullptr && buffer.u->refcount > 1))
+    {
+      buffer.release();
+    }
+    uint64_t frame_time_stamp;
+    if (!replay_buffer->getImage(time_stamp, &buffer, &frame_time_stamp))
+    {
+      // Frame left the window of the buffer
+      return;
+    }
+    int frame_index = indices_by_time_stamp.at(frame_time_stamp);
+    *out = CalibratedImage(buffer, getCameraModel(&meta_information.frames(frame_index)));
+    return;
   }
-
   int index = indices_by_time_stamp.size() - 1;
+  *out = CalibratedImage(img, getCameraModel(&meta_information.frames(index)));
+}
 
-  CameraMetaInformation camera_meta;
-  if (meta_information.has_camera_parameters())
-  {
-    camera_meta.mutable_camera_parameters()->CopyFrom(meta_information.camera_parameters());
-  }
-
-  const FrameEntry& frame = meta_information.frames(index);
-  if (frame.has_pose())
-  {
-    camera_meta.mutable_pose()->CopyFrom(frame.pose());
-  }
-  else if (meta_information.has_default_pose())
+uint64_t OpenCVImageProvider::getStart() const
+{
+  if (replay_buffer && replay_buffer->size() > 0)
   {
-    camera_meta.mutable_pose()->CopyFrom(meta_information.default_pose());
+    return replay_buffer->getStart();
   }
-
-  return CalibratedImage(img, camera_meta);
+  return getEnd();
 }
 
 void OpenCVImageProvider::update()
@@ -133,6 +160,10 @@ cv::Mat OpenCVImageProvider::getNextImg()
   {
     output.write(img);
   }
+  if (replay_buffer)
+  {
+    replay_buffer->push(time_stamp, img);
+  }
   return img;
 }
 
@@ -0,0 +1,197 @@
+#include "hl_monitoring/pose_timeline.h"
+
+#include <hl_communication/utils.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace hl_monitoring
+{
+PoseTimeline::PoseTimeline() : cursor(0)
+{
+}
+
+void PoseTimeline::clear()
+{
+  samples.clear();
+  cursor = 0;
+}
+
+void PoseTimeline::addSample(uint64_t time_stamp, const Pose3D& pose)
+{
+  if (pose.rotation_size() != 3)
+  {
+    throw std::runtime_error(HL_DEBUG + "Only Rodrigues rotation vector is supported currently");
+  }
+  if (pose.translation_size() != 3)
+  {
+    throw std::runtime_error(HL_DEBUG + "Size of translation in Pose3D is not valid (only 3 is accepted)");
+  }
+  Sample sample;
+  sample.time_stamp = time_stamp;
+  for (int dim = 0; dim < 3; dim++)
+  {
+    sample.rotation[dim] = pose.rotation(dim);
+    sample.translation[dim] = pose.translation(dim);
+  }
+  sample.quaternion = rodriguesToQuaternion(sample.rotation);
+  if (samples.empty() || samples.back().time_stamp < time_stamp)
+  {
+    samples.push_back(sample);
+    return;
+  }
+  auto it = std::lower_bound(samples.begin(), samples.end(), time_stamp,
+                             [](const Sample& s, uint64_t ts) { return s.time_stamp < ts; });
+  if (it != samples.end() && it->time_stamp == time_stamp)
+  {
+    *it = sample;
+  }
+  else
+  {
+    samples.insert(it, sample);
+  }
+}
+
+bool PoseTimeline::empty() const
+{
+  return samples.empty();
+}
+
+size_t PoseTimeline::size() const
+{
+  return samples.size();
+}
+
+uint64_t PoseTimeline::getStart() const
+{
+  if (samples.empty())
+    return 0;
+  return samples.front().time_stamp;
+}
+
+uint64_t PoseTimeline::getEnd() const
+{
+  if (samples.empty())
+    return 0;
+  return samples.back().time_stamp;
+}
+
+bool PoseTimeline::getPose(uint64_t time_stamp, Pose3D* pose)
+{
+  if (samples.empty())
+  {
+    return false;
+  }
+  if (time_stamp <= samples.front().time_stamp)
+  {
+    exportSample(samples.front(), pose);
+    return true;
+  }
+  if (time_stamp >= samples.back().time_stamp)
+  {
+    exportSample(samples.back(), pose);
+    return true;
+  }
+  size_t idx = getSegment(time_stamp);
+  const Sample& start = samples[idx];
+  const Sample& end = samples[idx + 1];
+  if (start.time_stamp == time_stamp)
+  {
+    exportSample(start, pose);
+    return true;
+  }
+  double t = (time_stamp - start.time_stamp) / (double)(end.time_stamp - start.time_stamp);
+  cv::Vec3d rotation = quaternionToRodrigues(slerp(start.quaternion, end.quaternion, t));
+  cv::Vec3d translation = (1 - t) * start.translation + t * end.translation;
+  pose->clear_rotation();
+  pose->clear_translation();
+  for (int dim = 0; dim < 3; dim++)
+  {
+    pose->add_rotation(rotation[dim]);
+    pose->add_translation(translation[dim]);
+  }
+  return true;
+}
+
+size_t PoseTimeline::getSegment(uint64_t time_stamp)
+{
+  // Most queries are in the current segment or in the next one
+  for (size_t idx = cursor; idx < std::min(cursor + 2, samples.size() - 1); idx++)
+  {
+    if (samples[idx].time_stamp <= time_stamp && time_stamp < samples[idx + 1].time_stamp)
+    {
+      cursor = idx;
+      return cursor;
+    }
+  }
+  auto it = std::upper_bound(samples.begin(), samples.end(), time_stamp,
+                             [](uint64_t ts, const Sample& s) { return ts < s.time_stamp; });
+  cursor = (it - samples.begin()) - 1;
+  return cursor;
+}
+
+void PoseTimeline::exportSample(const Sample& sample, Pose3D* pose)
+{
+  pose->clear_rotation();
+  pose->clear_translation();
+  for (int dim = 0; dim < 3; dim++)
+  {
+    pose->add_rotation(sample.rotation[dim]);
+    pose->add_translation(sample.translation[dim]);
+  }
+}
+
+cv::Vec4d rodriguesToQuaternion(const cv::Vec3d& rvec)
+{
+  double angle = cv::norm(rvec);
+  if (angle < 1e-12)
+  {
+    // First order approximation of sin(angle/2) * axis
+    return cv::normalize(cv::Vec4d(1, rvec[0] / 2, rvec[1] / 2, rvec[2] / 2));
+  }
+  double s = std::sin(angle / 2) / angle;
+  cv::Vec4d q(std::cos(angle / 2), s * rvec[0], s * rvec[1], s * rvec[2]);
+  return q[0] < 0 ? -q : q;
+}
+
+cv::Vec3d quaternionToRodrigues(const cv::Vec4d& q)
+{
+  double w = q[0];
+  cv::Vec3d v(q[1], q[2], q[3]);
+  if (w < 0)
+  {
+    w = -w;
+    v = -v;
+  }
+  double sin_half = cv::norm(v);
+  if (sin_half < 1e-12)
+  {
+    return 2 * v;
+  }
+  double angle = 2 * std::atan2(sin_half, w);
+  return v * (angle / sin_half);
+}
+
+cv::Vec4d slerp(const cv::Vec4d& q1, const cv::Vec4d& q2, double t)
+{
+  cv::Vec4d target = q2;
+  double dot = q1.dot(q2);
+  // Using the shortest path
+  if (dot < 0)
+  {
+    target = -target;
+    dot = -dot;
+  }
+  // Close quaternions: linear interpolation avoids numerical issues
+  if (dot > 0.9995)
+  {
+    return cv::normalize((1 - t) * q1 + t * target);
+  }
+  double theta = std::acos(dot);
+  double sin_theta = std::sin(theta);
+  double w1 = std::sin((1 - t) * theta) / sin_theta;
+  double w2 = std::sin(t * theta) / sin_theta;
+  return w1 * q1 + w2 * target;
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,231 @@
+#include "hl_monitoring/pose_tracker.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/utils.h>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace hl_monitoring
+{
+PoseTracker::PoseTracker(const Field& field, double sample_spacing_, int search_radius_)
+  : min_matches(30)
+  , max_error(3.0)
+  , nb_iterations(3)
+  , white_threshold(30)
+  , sample_spacing(sample_spacing_)
+  , search_radius(search_radius_)
+  , has_pose(false)
+  , nb_matches(0)
+  , error(0)
+{
+  if (sample_spacing <= 0)
+  {
+    throw std::logic_error(HL_DEBUG + "invalid sample spacing: " + std::to_string(sample_spacing));
+  }
+  // Second point is close enough to approximate the direction of the line once distorted
+  float direction_step = std::min(0.05, sample_spacing / 2);
+  for (const Field::Segment& line : field.getWhiteLines())
+  {
+    cv::Point3f dir = line.second - line.first;
+    double length = cv::norm(dir);
+    if (length <= 0)
+    {
+      continue;
+    }
+    dir *= 1.0 / length;
+    int nb_intervals = std::max(1, (int)(length / sample_spacing));
+    for (int idx = 0; idx <= nb_intervals; idx++)
+    {
+      cv::Point3f sample = line.first + dir * (float)(length * idx / nb_intervals);
+      samples.push_back(sample);
+      sample_ends.push_back(sample + dir * direction_step);
+    }
+  }
+}
+
+void PoseTracker::setIntrinsic(const IntrinsicParameters& camera_parameters)
+{
+  camera_meta.mutable_camera_parameters()->CopyFrom(camera_parameters);
+  cv::Size img_size;
+  intrinsicToCV(camera_parameters, &camera_matrix, &distortion_coefficients, &img_size);
+}
+
+void PoseTracker::setPose(const Pose3D& pose)
+{
+  camera_meta.mutable_pose()->CopyFrom(pose);
+  has_pose = true;
+}
+
+bool PoseTracker::hasPose() const
+{
+  return has_pose;
+}
+
+bool PoseTracker::update(const cv::Mat& img, Pose3D* pose)
+{
+  if (!camera_meta.has_camera_parameters())
+  {
+    throw std::logic_error(HL_DEBUG + "intrinsic parameters have not been set");
+  }
+  if (!has_pose)
+  {
+    throw std::logic_error(HL_DEBUG + "no initial pose");
+  }
+  updateWhiteMask(img);
+  cv::Mat rvec, tvec;
+  pose3DToCV(camera_meta.pose(), &rvec, &tvec);
+  bool success = true;
+  for (int iter = 0; iter < nb_iterations; iter++)
+  {
+    nb_matches = matchSamples(rvec, tvec);
+    if (nb_matches < min_matches)
+    {
+      success = false;
+      break;
+    }
+    cv::solvePnP(matched_in_field, matched_in_img, camera_matrix, distortion_coefficients, rvec, tvec, true,
+                 cv::SOLVEPNP_ITERATIVE);
+  }
+  if (success)
+  {
+    // Error is measured with the matches used for the last optimization
+    std::vector<cv::Point2f> reprojected;
+    getModel(rvec, tvec).fieldToImg(matched_in_field, &reprojected);
+    double squared_error = 0;
+    for (size_t idx = 0; idx < reprojected.size(); idx++)
+    {
+      cv::Point2f diff = reprojected[idx] - matched_in_img[idx];
+      squared_error += diff.dot(diff);
+    }
+    error = std::sqrt(squared_error / reprojected.size());
+    success = error <= max_error;
+  }
+  if (success)
+  {
+    cvToPose3D(rvec, tvec, camera_meta.mutable_pose());
+  }
+  pose->CopyFrom(camera_meta.pose());
+  return success;
+}
+
+bool PoseTracker::update(const cv::Mat& img, FrameEntry* frame)
+{
+  return update(img, frame->mutable_pose());
+}
+
+int PoseTracker::getNbMatches() const
+{
+  return nb_matches;
+}
+
+double PoseTracker::getError() const
+{
+  return error;
+}
+
+const cv::Mat& PoseTracker::getWhiteMask() const
+{
+  return white_mask;
+}
+
+void PoseTracker::updateWhiteMask(const cv::Mat& img)
+{
+  if (img.channels() == 3)
+  {
+    cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+  }
+  else
+  {
+    gray = img;
+  }
+  // Box filter cost does not depend on its size, neighborhood has to be
+  // significantly wider than the lines
+  int neighborhood_size = 31;
+  cv::blur(gray, background, cv::Size(neighborhood_size, neighborhood_size));
+  cv::subtract(gray, background, white_mask);
+  cv::threshold(white_mask, white_mask, white_threshold, 255, cv::THRESH_BINARY);
+}
+
+int PoseTracker::matchSamples(const cv::Mat& rvec, const cv::Mat& tvec)
+{
+  CameraModel model = getModel(rvec, tvec);
+  size_t nb_samples = samples.size();
+  projection_input.clear();
+  projection_input.insert(projection_input.end(), samples.begin(), samples.end());
+  projection_input.insert(projection_input.end(), sample_ends.begin(), sample_ends.end());
+  model.fieldToImg(projection_input, &projection_output, &projection_visible);
+  matched_in_field.clear();
+  matched_in_img.clear();
+  for (size_t idx = 0; idx < nb_samples; idx++)
+  {
+    if (!projection_visible[idx] || !model.isInFront(sample_ends[idx]))
+    {
+      continue;
+    }
+    const cv::Point2f& pos = projection_output[idx];
+    cv::Point2f dir = projection_output[nb_samples + idx] - pos;
+    double dir_norm = cv::norm(dir);
+    if (dir_norm < 1e-3)
+    {
+      continue;
+    }
+    cv::Point2f normal(-dir.y / dir_norm, dir.x / dir_norm);
+    float offset;
+    if (searchAlongNormal(pos, normal, &offset))
+    {
+      matched_in_field.push_back(samples[idx]);
+      matched_in_img.push_back(pos + offset * normal);
+    }
+  }
+  return matched_in_field.size();
+}
+
+bool PoseTracker::searchAlongNormal(const cv::Point2f& pos, const cv::Point2f& normal, float* offset) const
+{
+  bool found = false;
+  float best_dist = std::numeric_limits<float>::max();
+  bool in_run = false;
+  int run_start = 0;
+  // Last step is out of the window to close the current run
+  for (int step = -search_radius; step <= search_radius + 1; step++)
+  {
+    bool white = false;
+    if (step <= search_radius)
+    {
+      int x = cvRound(pos.x + step * normal.x);
+      int y = cvRound(pos.y + step * normal.y);
+      white = x >= 0 && y >= 0 && x < white_mask.cols && y < white_mask.rows && white_mask.at<uint8_t>(y, x) != 0;
+    }
+    if (white && !in_run)
+    {
+      in_run = true;
+      run_start = step;
+    }
+    else if (!white && in_run)
+    {
+      in_run = false;
+      float run_center = (run_start + step - 1) / 2.0f;
+      if (std::fabs(run_center) < best_dist)
+      {
+        best_dist = std::fabs(run_center);
+        *offset = run_center;
+        found = true;
+      }
+    }
+  }
+  return found;
+}
+
+CameraModel PoseTracker::getModel(const cv::Mat& rvec, const cv::Mat& tvec) const
+{
+  CameraMetaInformation model_meta;
+  model_meta.mutable_camera_parameters()->CopyFrom(camera_meta.camera_parameters());
+  cvToPose3D(rvec, tvec, model_meta.mutable_pose());
+  return CameraModel(model_meta);
+}
+
+}  // namespace hl_monitoring
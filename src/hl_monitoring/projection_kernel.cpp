@@ -0,0 +1,113 @@
+#include "hl_monitoring/projection_kernel.h"
+
+#include <hl_communication/utils.h>
+
+#include <stdexcept>
+
+namespace hl_monitoring
+{
+DistortionModel getDistortionModel(int distortion_size)
+{
+  if (distortion_size <= 0)
+  {
+    return DistortionModel::None;
+  }
+  else if (distortion_size <= 2)
+  {
+    return DistortionModel::K1K2;
+  }
+  else if (distortion_size <= 5)
+  {
+    return DistortionModel::K1K2P1P2K3;
+  }
+  else if (distortion_size <= 8)
+  {
+    return DistortionModel::Rational;
+  }
+  throw std::out_of_range(HL_DEBUG + "no distortion model for " + std::to_string(distortion_size) + " coefficients");
+}
+
+template <DistortionModel model>
+void projectFieldPoints(const ProjectionParameters& params, const float* __restrict x, const float* __restrict y,
+                        const float* __restrict z, size_t nb_points, float* __restrict u, float* __restrict v,
+                        float* __restrict depth)
+{
+  // Copies to locals ensure the compiler does not reload them after each store
+  const float r0 = params.rotation[0], r1 = params.rotation[1], r2 = params.rotation[2];
+  const float r3 = params.rotation[3], r4 = params.rotation[4], r5 = params.rotation[5];
+  const float r6 = params.rotation[6], r7 = params.rotation[7], r8 = params.rotation[8];
+  const float tx = params.translation[0], ty = params.translation[1], tz = params.translation[2];
+  const float fx = params.fx, fy = params.fy, cx = params.cx, cy = params.cy;
+  const float k1 = params.distortion[0], k2 = params.distortion[1];
+  const float p1 = params.distortion[2], p2 = params.distortion[3];
+  const float k3 = params.distortion[4], k4 = params.distortion[5];
+  const float k5 = params.distortion[6], k6 = params.distortion[7];
+  for (size_t idx = 0; idx < nb_points; idx++)
+  {
+    float cam_x = r0 * x[idx] + r1 * y[idx] + r2 * z[idx] + tx;
+    float cam_y = r3 * x[idx] + r4 * y[idx] + r5 * z[idx] + ty;
+    float cam_z = r6 * x[idx] + r7 * y[idx] + r8 * z[idx] + tz;
+    // No special case for cam_z == 0: such points are flagged by depth anyway
+    float inv_z = 1.0f / cam_z;
+    float xn = cam_x * inv_z;
+    float yn = cam_y * inv_z;
+    float xd = xn, yd = yn;
+    // Conditions are known at compile-time: unused terms are removed
+    if (model != DistortionModel::None)
+    {
+      float rho2 = xn * xn + yn * yn;
+      float radial = 1 + rho2 * (k1 + rho2 * k2);
+      if (model == DistortionModel::K1K2P1P2K3 || model == DistortionModel::Rational)
+      {
+        radial = 1 + rho2 * (k1 + rho2 * (k2 + rho2 * k3));
+      }
+      if (model == DistortionModel::Rational)
+      {
+        radial /= 1 + rho2 * (k4 + rho2 * (k5 + rho2 * k6));
+      }
+      xd = xn * radial;
+      yd = yn * radial;
+      if (model == DistortionModel::K1K2P1P2K3 || model == DistortionModel::Rational)
+      {
+        float xy = xn * yn;
+        xd += 2 * p1 * xy + p2 * (rho2 + 2 * xn * xn);
+        yd += p1 * (rho2 + 2 * yn * yn) + 2 * p2 * xy;
+      }
+    }
+    u[idx] = fx * xd + cx;
+    v[idx] = fy * yd + cy;
+    depth[idx] = cam_z;
+  }
+}
+
+template void projectFieldPoints<DistortionModel::None>(const ProjectionParameters&, const float*, const float*,
+                                                        const float*, size_t, float*, float*, float*);
+template void projectFieldPoints<DistortionModel::K1K2>(const ProjectionParameters&, const float*, const float*,
+                                                        const float*, size_t, float*, float*, float*);
+template void projectFieldPoints<DistortionModel::K1K2P1P2K3>(const ProjectionParameters&, const float*,
+                                                              const float*, const float*, size_t, float*, float*,
+                                                              float*);
+template void projectFieldPoints<DistortionModel::Rational>(const ProjectionParameters&, const float*, const float*,
+                                                            const float*, size_t, float*, float*, float*);
+
+void projectFieldPoints(DistortionModel model, const ProjectionParameters& params, const float* x, const float* y,
+                        const float* z, size_t nb_points, float* u, float* v, float* depth)
+{
+  switch (model)
+  {
+    case DistortionModel::None:
+      projectFieldPoints<DistortionModel::None>(params, x, y, z, nb_points, u, v, depth);
+      break;
+    case DistortionModel::K1K2:
+      projectFieldPoints<DistortionModel::K1K2>(params, x, y, z, nb_points, u, v, depth);
+      break;
+    case DistortionModel::K1K2P1P2K3:
+      projectFieldPoints<DistortionModel::K1K2P1P2K3>(params, x, y, z, nb_points, u, v, depth);
+      break;
+    case DistortionModel::Rational:
+      projectFieldPoints<DistortionModel::Rational>(params, x, y, z, nb_points, u, v, depth);
+      break;
+  }
+}
+
+}  // namespace hl_monitoring
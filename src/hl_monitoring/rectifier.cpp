@@ -0,0 +1,120 @@
+#include "hl_monitoring/rectifier.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/utils.h>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <sstream>
+
+namespace hl_monitoring
+{
+Rectifier::Rectifier(double alpha_, int nb_bands_) : alpha(alpha_), nb_bands(nb_bands_), has_intrinsic(false)
+{
+  if (nb_bands < 1)
+  {
+    throw std::logic_error(HL_DEBUG + "invalid number of bands: " + std::to_string(nb_bands));
+  }
+}
+
+void Rectifier::setIntrinsic(const IntrinsicParameters& camera_parameters)
+{
+  if (has_intrinsic && isSameIntrinsic(&source_intrinsic, &camera_parameters))
+  {
+    return;
+  }
+  source_intrinsic.CopyFrom(camera_parameters);
+  has_intrinsic = true;
+  updateMaps();
+}
+
+bool Rectifier::hasIntrinsic() const
+{
+  return has_intrinsic;
+}
+
+const IntrinsicParameters& Rectifier::getRectifiedIntrinsic() const
+{
+  if (!has_intrinsic)
+  {
+    throw std::logic_error(HL_DEBUG + "intrinsic parameters have not been set");
+  }
+  return rectified_intrinsic;
+}
+
+void Rectifier::rectify(const cv::Mat& src, cv::Mat* dst) const
+{
+  if (!has_intrinsic)
+  {
+    throw std::logic_error(HL_DEBUG + "intrinsic parameters have not been set");
+  }
+  if (src.size() != map1.size())
+  {
+    std::ostringstream oss;
+    oss << HL_DEBUG << " size mismatch " << src.size() << " != " << map1.size();
+    throw std::runtime_error(oss.str());
+  }
+  if (nb_bands == 1)
+  {
+    cv::remap(src, *dst, map1, map2, cv::INTER_LINEAR);
+    return;
+  }
+  dst->create(src.size(), src.type());
+  cv::Mat& output = *dst;
+  int rows = src.rows;
+  int bands = nb_bands;
+  const cv::Mat& band_map1 = map1;
+  const cv::Mat& band_map2 = map2;
+  // Each band of the output only depends on the same band of the maps
+  cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+    for (int band = range.start; band < range.end; band++)
+    {
+      int start = band * rows / bands;
+      int end = (band + 1) * rows / bands;
+      cv::Mat output_band = output.rowRange(start, end);
+      cv::remap(src, output_band, band_map1.rowRange(start, end), band_map2.rowRange(start, end), cv::INTER_LINEAR);
+    }
+  });
+}
+
+CalibratedImage Rectifier::rectify(const CalibratedImage& img)
+{
+  if (!img.hasCameraParameters())
+  {
+    throw std::runtime_error(HL_DEBUG + "image has no camera parameters");
+  }
+  const CameraMetaInformation& camera_meta = img.getCameraInformation();
+  setIntrinsic(camera_meta.camera_parameters());
+  const Pose3D* pose = camera_meta.has_pose() ? &camera_meta.pose() : nullptr;
+  if (!rectified_model || !rectified_model->matches(&rectified_intrinsic, pose))
+  {
+    CameraMetaInformation rectified_meta;
+    rectified_meta.mutable_camera_parameters()->CopyFrom(rectified_intrinsic);
+    if (pose != nullptr)
+    {
+      rectified_meta.mutable_pose()->CopyFrom(*pose);
+    }
+    rectified_model = std::make_shared<CameraModel>(rectified_meta);
+  }
+  cv::Mat rectified_img;
+  rectify(img.getImg(), &rectified_img);
+  return CalibratedImage(rectified_img, rectified_model);
+}
+
+void Rectifier::updateMaps()
+{
+  cv::Mat camera_matrix, distortion_coeffs;
+  cv::Size img_size;
+  intrinsicToCV(source_intrinsic, &camera_matrix, &distortion_coeffs, &img_size);
+  cv::Mat new_camera_matrix = cv::getOptimalNewCameraMatrix(camera_matrix, distortion_coeffs, img_size, alpha);
+  // Rectified intrinsic are stored with integer optical center, maps are
+  // computed from the stored values to ensure consistency
+  cvToIntrinsic(new_camera_matrix, cv::Mat(), img_size, &rectified_intrinsic);
+  cv::Mat rectified_distortion;
+  intrinsicToCV(rectified_intrinsic, &new_camera_matrix, &rectified_distortion, &img_size);
+  cv::initUndistortRectifyMap(camera_matrix, distortion_coeffs, cv::Mat(), new_camera_matrix, img_size, CV_16SC2,
+                              map1, map2);
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,205 @@
+#include "hl_monitoring/replay_buffer.h"
+
+#include <hl_communication/utils.h>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+
+namespace hl_monitoring
+{
+ReplayBuffer::ReplayBuffer(double duration_, int jpeg_quality_, size_t max_pending_)
+  : duration(duration_ * 1000 * 1000)
+  , jpeg_quality(jpeg_quality_)
+  , max_pending(max_pending_)
+  , memory_usage(0)
+  , nb_dropped(0)
+  , stop(false)
+{
+  if (duration_ <= 0)
+  {
+    throw std::runtime_error(HL_DEBUG + " duration of the replay buffer should be strictly positive");
+  }
+  if (jpeg_quality < 0 || jpeg_quality > 100)
+  {
+    throw std::runtime_error(HL_DEBUG + " jpeg quality should be in [0,100], received " +
+                             std::to_string(jpeg_quality));
+  }
+  if (max_pending == 0)
+  {
+    throw std::runtime_error(HL_DEBUG + " max_pending should be strictly positive");
+  }
+  worker = std::thread(&ReplayBuffer::compressFrames, this);
+}
+
+ReplayBuffer::~ReplayBuffer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  pending_condition.notify_one();
+  worker.join();
+}
+
+void ReplayBuffer::push(uint64_t time_stamp, const cv::Mat& img)
+{
+  PendingFrame frame;
+  frame.time_stamp = time_stamp;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending.size() >= max_pending)
+    {
+      nb_dropped++;
+      return;
+    }
+    if (!spare_images.empty())
+    {
+      frame.img = spare_images.back();
+      spare_images.pop_back();
+    }
+  }
+  // Copy is done without locking, the spare image is not shared anymore
+  img.copyTo(frame.img);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(frame);
+    dropOldFrames();
+  }
+  pending_condition.notify_one();
+}
+
+bool ReplayBuffer::getImage(uint64_t time_stamp, cv::Mat* img, uint64_t* frame_time_stamp) const
+{
+  std::shared_ptr<const std::vector<uchar>> data;
+  uint64_t found_time_stamp;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = pending.rbegin(); it != pending.rend(); it++)
+    {
+      if (it->time_stamp <= time_stamp)
+      {
+        it->img.copyTo(*img);
+        if (frame_time_stamp != nullptr)
+        {
+          *frame_time_stamp = it->time_stamp;
+        }
+        return true;
+      }
+    }
+    auto it = std::upper_bound(
+        frames.begin(), frames.end(), time_stamp,
+        [](uint64_t time_stamp, const CompressedFrame& frame) { return time_stamp < frame.time_stamp; });
+    if (it == frames.begin())
+    {
+      return false;
+    }
+    it--;
+    found_time_stamp = it->time_stamp;
+    // Only the pointer is copied, the data is kept alive even if the frame is dropped meanwhile
+    data = it->data;
+  }
+  // Decoding is the expensive part, it does not block the stream
+  cv::imdecode(*data, cv::IMREAD_COLOR, img);
+  if (img->empty())
+  {
+    throw std::runtime_error(HL_DEBUG + " failed to decode frame " + std::to_string(found_time_stamp));
+  }
+  if (frame_time_stamp != nullptr)
+  {
+    *frame_time_stamp = found_time_stamp;
+  }
+  return true;
+}
+
+uint64_t ReplayBuffer::getStart() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!frames.empty())
+  {
+    return frames.front().time_stamp;
+  }
+  return pending.empty() ? 0 : pending.front().time_stamp;
+}
+
+uint64_t ReplayBuffer::getEnd() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!pending.empty())
+  {
+    return pending.back().time_stamp;
+  }
+  return frames.empty() ? 0 : frames.back().time_stamp;
+}
+
+size_t ReplayBuffer::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return frames.size() + pending.size();
+}
+
+size_t ReplayBuffer::getMemoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return memory_usage;
+}
+
+size_t ReplayBuffer::getNbDropped() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return nb_dropped;
+}
+
+void ReplayBuffer::compressFrames()
+{
+  std::vector<int> params = { cv::IMWRITE_JPEG_QUALITY, jpeg_quality };
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    pending_condition.wait(lock, [this]() { return stop || !pending.empty(); });
+    if (stop)
+    {
+      return;
+    }
+    // The frame stays in pending during compression to remain available, push
+    // never modifies the images already pending
+    cv::Mat img = pending.front().img;
+    CompressedFrame frame;
+    frame.time_stamp = pending.front().time_stamp;
+    frame.data.swap(spare_data);
+    if (!frame.data)
+    {
+      frame.data = std::make_shared<std::vector<uchar>>();
+    }
+    lock.unlock();
+    cv::imencode(".jpg", img, *frame.data, params);
+    lock.lock();
+    memory_usage += frame.data->size();
+    frames.push_back(std::move(frame));
+    pending.pop_front();
+    spare_images.push_back(img);
+    dropOldFrames();
+  }
+}
+
+void ReplayBuffer::dropOldFrames()
+{
+  if (frames.empty())
+  {
+    return;
+  }
+  uint64_t end = pending.empty() ? frames.back().time_stamp : pending.back().time_stamp;
+  while (!frames.empty() && frames.front().time_stamp + duration < end)
+  {
+    std::shared_ptr<std::vector<uchar>>& data = frames.front().data;
+    memory_usage -= data->size();
+    // Buffer can only be reused if no reader is still decoding it
+    if (data.use_count() == 1)
+    {
+      spare_data.swap(data);
+    }
+    frames.pop_front();
+  }
+}
+
+}  // namespace hl_monitoring
@@ -1,22 +1,23 @@
 #include "hl_monitoring/replay_image_provider.h"
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/encoder_settings.h>
 
-#include <fstream>
 #include <iostream>
 
 namespace hl_monitoring
 {
-ReplayImageProvider::ReplayImageProvider()
+ReplayImageProvider::ReplayImageProvider() : frames_loaded(false), pose_timeline_loaded(false)
 {
 }
 
-ReplayImageProvider::ReplayImageProvider(const std::string& video_path)
+ReplayImageProvider::ReplayImageProvider(const std::string& video_path) : ReplayImageProvider()
 {
   loadVideo(video_path);
 }
 
 ReplayImageProvider::ReplayImageProvider(const std::string& video_path, const std::string& meta_information_path)
+  : ReplayImageProvider()
 {
   loadVideo(video_path);
   loadMetaInformation(meta_information_path);
@@ -24,37 +25,46 @@ ReplayImageProvider::ReplayImageProvider(const std::string& video_path, const st
 
 void ReplayImageProvider::loadVideo(const std::string& video_path)
 {
+  std::unique_lock<std::mutex> lock = lockVideoEnvironment();
   if (!video.open(video_path))
   {
     throw std::runtime_error("Failed to open video '" + video_path + "'");
   }
+  lock.unlock();
   index = 0;
   nb_frames = video.get(cv::CAP_PROP_FRAME_COUNT);
 }
 
 void ReplayImageProvider::loadMetaInformation(const std::string& meta_information_path)
 {
-  std::ifstream in(meta_information_path, std::ios::binary);
-  if (!in.good())
-  {
-    throw std::runtime_error("Failed to open file '" + meta_information_path + "'");
-  }
-  if (!meta_information.ParseFromIstream(&in))
-  {
-    throw std::runtime_error("Failed to read file '" + meta_information_path + "'");
-  }
+  frame_index.open(meta_information_path);
+  meta_information.CopyFrom(frame_index.getHeader());
+  indices_by_time_stamp.clear();
   index = 0;
-  nb_frames = meta_information.frames_size();
+  nb_frames = frame_index.size();
+  frames_loaded = false;
+  pose_timeline_loaded = false;
+  // No frames in meta_information: clears the timeline
+  updatePoseTimeline();
   std::cout << "After loading meta informations: " << nb_frames << " frames" << std::endl;
-  for (int idx = 0; idx < nb_frames; idx++)
+}
+
+void ReplayImageProvider::loadPoseTimeline()
+{
+  if (pose_timeline_loaded)
+  {
+    return;
+  }
+  Pose3D pose;
+  for (size_t idx = 0; idx < frame_index.size(); idx++)
   {
-    uint64_t time_stamp = meta_information.frames(idx).time_stamp();
-    if (indices_by_time_stamp.count(time_stamp) > 0)
+    const FrameIndexRecord& record = frame_index.getRecord(idx);
+    if (frame_index.getPose(record, &pose))
     {
-      throw std::runtime_error(HL_DEBUG + "Duplicated time_stamp " + std::to_string(time_stamp));
+      addPoseSample(record.time_stamp, pose);
     }
-    indices_by_time_stamp[time_stamp] = idx;
   }
+  pose_timeline_loaded = true;
 }
 
 void ReplayImageProvider::restartStream()
@@ -64,42 +74,49 @@ void ReplayImageProvider::restartStream()
 
 CalibratedImage ReplayImageProvider::getCalibratedImage(uint64_t time_stamp)
 {
-  int new_index = getIndex(time_stamp);
-  cv::Mat img;
-  if (new_index == -1)
+  if (!loadFrame(time_stamp))
   {
     return CalibratedImage();
   }
-  else if (new_index == index - 1) // Asking for previous image again
+  return CalibratedImage(last_img, getCameraModel(&frame_entry));
+}
+
+void ReplayImageProvider::getCalibratedImage(uint64_t time_stamp, CalibratedImage* out)
+{
+  // Releasing the previous model first allows to update it in place
+  out->clear();
+  if (loadFrame(time_stamp))
   {
-    img = last_img;
+    *out = CalibratedImage(last_img, getCameraModel(&frame_entry));
   }
-  else
+}
+
+bool ReplayImageProvider::loadFrame(uint64_t time_stamp)
+{
+  int record_idx = frame_index.find(time_stamp);
+  if (record_idx == -1)
+  {
+    return false;
+  }
+  const FrameIndexRecord& record = frame_index.getRecord(record_idx);
+  int new_index = record.frame_number;
+  // Asking for previous image again does not require decoding
+  if (new_index != index - 1)
   {
     if (new_index != index)
     {
       setIndex(new_index);
     }
-    img = getNextImg();
+    getNextImg();
   }
 
-  CameraMetaInformation camera_meta;
-  if (meta_information.has_camera_parameters())
+  frame_entry.set_time_stamp(record.time_stamp);
+  if (!frame_index.getPose(record, frame_entry.mutable_pose()))
   {
-    camera_meta.mutable_camera_parameters()->CopyFrom(meta_information.camera_parameters());
+    frame_entry.clear_pose();
   }
-
-  const FrameEntry& frame = meta_information.frames(index);
-  if (frame.has_pose())
-  {
-    camera_meta.mutable_pose()->CopyFrom(frame.pose());
-  }
-  else if (meta_information.has_default_pose())
-  {
-    camera_meta.mutable_pose()->CopyFrom(meta_information.default_pose());
-  }
-
-  return CalibratedImage(img, camera_meta);
+  loadPoseTimeline();
+  return true;
 }
 
 cv::Mat ReplayImageProvider::getNextImg()
@@ -138,18 +155,72 @@ void ReplayImageProvider::setIndex(int new_index)
   }
 }
 
-int ReplayImageProvider::getIndex(uint64_t time_stamp) const
+int ReplayImageProvider::getIndex(uint64_t time_stamp)
 {
-  if (indices_by_time_stamp.size() == 0 || indices_by_time_stamp.begin()->first > time_stamp)
+  int record_idx = frame_index.find(time_stamp);
+  if (record_idx == -1)
   {
     return -1;
   }
-  auto it = indices_by_time_stamp.upper_bound(time_stamp);
-  if (it == indices_by_time_stamp.end() || it->first > time_stamp)
+  return frame_index.getRecord(record_idx).frame_number;
+}
+
+const VideoMetaInformation& ReplayImageProvider::getMetaInformation()
+{
+  if (!frames_loaded && frame_index.isOpen())
+  {
+    google::protobuf::RepeatedPtrField<FrameEntry>* frames = meta_information.mutable_frames();
+    frames->Clear();
+    frames->Reserve(frame_index.size());
+    for (size_t idx = 0; idx < frame_index.size(); idx++)
+    {
+      frames->Add();
+    }
+    for (size_t idx = 0; idx < frame_index.size(); idx++)
+    {
+      const FrameIndexRecord& record = frame_index.getRecord(idx);
+      if (record.frame_number >= frame_index.size())
+      {
+        throw std::runtime_error(HL_DEBUG + "invalid frame number in index: " + std::to_string(record.frame_number));
+      }
+      FrameEntry* frame = frames->Mutable(record.frame_number);
+      frame->set_time_stamp(record.time_stamp);
+      if (!frame_index.getPose(record, frame->mutable_pose()))
+      {
+        frame->clear_pose();
+      }
+    }
+    frames_loaded = true;
+  }
+  return meta_information;
+}
+
+uint64_t ReplayImageProvider::getFrameTimeStamp(uint64_t time_stamp) const
+{
+  int record_idx = frame_index.find(time_stamp);
+  if (record_idx == -1)
+  {
+    return 0;
+  }
+  return frame_index.getRecord(record_idx).time_stamp;
+}
+
+uint64_t ReplayImageProvider::getStart() const
+{
+  if (frame_index.isOpen())
+  {
+    return frame_index.getStart();
+  }
+  return ImageProvider::getStart();
+}
+
+uint64_t ReplayImageProvider::getEnd() const
+{
+  if (frame_index.isOpen())
   {
-    it--;
+    return frame_index.getEnd();
   }
-  return it->second;
+  return ImageProvider::getEnd();
 }
 
 }  // namespace hl_monitoring
@@ -0,0 +1,149 @@
+#include "hl_monitoring/shared_memory_frame_bus.h"
+
+#include <hl_communication/utils.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace hl_monitoring
+{
+static size_t alignFrameBus(size_t size)
+{
+  return (size + frame_bus_alignment - 1) / frame_bus_alignment * frame_bus_alignment;
+}
+
+size_t getFrameBusMetaOffset()
+{
+  return alignFrameBus(sizeof(FrameSlotHeader));
+}
+
+size_t getFrameBusImageOffset(uint32_t meta_capacity)
+{
+  return getFrameBusMetaOffset() + alignFrameBus(meta_capacity);
+}
+
+size_t getFrameBusSlotsOffset()
+{
+  return alignFrameBus(sizeof(FrameBusHeader));
+}
+
+SharedMemoryFramePublisher::SharedMemoryFramePublisher(const std::string& name_, const cv::Size& img_size,
+                                                       int img_type, int nb_slots, size_t meta_capacity,
+                                                       bool unlink_existing)
+  : name(name_), fd(-1), data(nullptr), data_size(0), header(nullptr)
+{
+  if (nb_slots <= 0)
+  {
+    throw std::logic_error(HL_DEBUG + "invalid number of slots: " + std::to_string(nb_slots));
+  }
+  uint32_t img_step = img_size.width * CV_ELEM_SIZE(img_type);
+  size_t slot_size = alignFrameBus(getFrameBusImageOffset(meta_capacity) + img_step * img_size.height);
+  data_size = getFrameBusSlotsOffset() + nb_slots * slot_size;
+
+  if (unlink_existing)
+  {
+    shm_unlink(name.c_str());
+  }
+  // Truncating an existing segment would corrupt the frames of attached readers
+  fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0 && errno == EEXIST)
+  {
+    throw std::runtime_error(HL_DEBUG + "Shared memory '" + name +
+                             "' already exists: another publisher is running or a previous one was not closed");
+  }
+  if (fd < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to create shared memory '" + name + "': " + strerror(errno));
+  }
+  if (ftruncate(fd, data_size) != 0)
+  {
+    close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error(HL_DEBUG + "Failed to resize shared memory '" + name + "': " + strerror(errno));
+  }
+  void* ptr = mmap(nullptr, data_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED)
+  {
+    close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error(HL_DEBUG + "Failed to map shared memory '" + name + "': " + strerror(errno));
+  }
+  data = (uint8_t*)ptr;
+  // Segment is zero-initialized by ftruncate: all slots have a 0 sequence
+  header = new (data) FrameBusHeader();
+  header->nb_slots = nb_slots;
+  header->slot_size = slot_size;
+  header->meta_capacity = meta_capacity;
+  header->img_width = img_size.width;
+  header->img_height = img_size.height;
+  header->img_type = img_type;
+  header->img_step = img_step;
+  header->time_offset.store(0);
+  header->nb_published.store(0);
+  header->closed.store(false);
+  for (int slot = 0; slot < nb_slots; slot++)
+  {
+    new (data + getFrameBusSlotsOffset() + slot * slot_size) FrameSlotHeader();
+  }
+  header->version = frame_bus_version;
+  // Magic is written last: readers consider the bus invalid until then
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = frame_bus_magic;
+}
+
+SharedMemoryFramePublisher::~SharedMemoryFramePublisher()
+{
+  header->closed.store(true);
+  munmap(data, data_size);
+  close(fd);
+  shm_unlink(name.c_str());
+}
+
+const std::string& SharedMemoryFramePublisher::getName() const
+{
+  return name;
+}
+
+void SharedMemoryFramePublisher::publish(uint64_t time_stamp, const CalibratedImage& calibrated_img)
+{
+  const cv::Mat& img = calibrated_img.getImg();
+  if (img.cols != header->img_width || img.rows != header->img_height || img.type() != header->img_type)
+  {
+    std::ostringstream oss;
+    oss << HL_DEBUG << "image mismatch on bus '" << name << "': received " << img.size() << " (type " << img.type()
+        << ") expecting " << cv::Size(header->img_width, header->img_height) << " (type " << header->img_type << ")";
+    throw std::runtime_error(oss.str());
+  }
+  calibrated_img.getCameraInformation().SerializeToString(&meta_buffer);
+  if (meta_buffer.size() > header->meta_capacity)
+  {
+    throw std::runtime_error(HL_DEBUG + "camera information too large for bus '" + name + "'");
+  }
+
+  uint64_t frame_number = header->nb_published.load();
+  uint8_t* slot = data + getFrameBusSlotsOffset() + (frame_number % header->nb_slots) * header->slot_size;
+  FrameSlotHeader* slot_header = (FrameSlotHeader*)slot;
+  slot_header->sequence.store(2 * frame_number + 1);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot_header->time_stamp.store(time_stamp, std::memory_order_relaxed);
+  slot_header->meta_size.store(meta_buffer.size(), std::memory_order_relaxed);
+  memcpy(slot + getFrameBusMetaOffset(), meta_buffer.data(), meta_buffer.size());
+  cv::Mat slot_img(header->img_height, header->img_width, header->img_type,
+                   slot + getFrameBusImageOffset(header->meta_capacity), header->img_step);
+  img.copyTo(slot_img);
+  slot_header->sequence.store(2 * frame_number + 2, std::memory_order_release);
+  header->nb_published.store(frame_number + 1, std::memory_order_release);
+}
+
+void SharedMemoryFramePublisher::setOffset(int64_t offset)
+{
+  header->time_offset.store(offset);
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,229 @@
+#include "hl_monitoring/shared_memory_image_provider.h"
+
+#include <hl_communication/utils.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hl_monitoring
+{
+SharedMemoryImageProvider::SharedMemoryImageProvider(const std::string& bus_name_)
+  : bus_name(bus_name_), fd(-1), data(nullptr), data_size(0), header(nullptr), end(0)
+{
+  fd = shm_open(bus_name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open shared memory '" + bus_name + "': " + strerror(errno));
+  }
+  struct stat shm_stat;
+  if (fstat(fd, &shm_stat) != 0 || (size_t)shm_stat.st_size < sizeof(FrameBusHeader))
+  {
+    close(fd);
+    throw std::runtime_error(HL_DEBUG + "Invalid size for shared memory '" + bus_name + "'");
+  }
+  data_size = shm_stat.st_size;
+  void* ptr = mmap(nullptr, data_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED)
+  {
+    close(fd);
+    throw std::runtime_error(HL_DEBUG + "Failed to map shared memory '" + bus_name + "': " + strerror(errno));
+  }
+  data = (uint8_t*)ptr;
+  header = (const FrameBusHeader*)data;
+  if (header->magic != frame_bus_magic || header->version != frame_bus_version ||
+      getFrameBusSlotsOffset() + header->nb_slots * header->slot_size > data_size)
+  {
+    munmap(data, data_size);
+    close(fd);
+    throw std::runtime_error(HL_DEBUG + "Shared memory '" + bus_name + "' is not a valid frame bus");
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // Start reading with the oldest frame available
+  index = getOldestFrameNumber();
+  update();
+}
+
+SharedMemoryImageProvider::~SharedMemoryImageProvider()
+{
+  munmap(data, data_size);
+  close(fd);
+}
+
+void SharedMemoryImageProvider::restartStream()
+{
+  throw std::logic_error("It makes no sense to restart the stream in a 'SharedMemoryImageProvider'");
+}
+
+CalibratedImage SharedMemoryImageProvider::getCalibratedImage(uint64_t time_stamp)
+{
+  uint64_t frame_number, frame_time_stamp;
+  cv::Mat img;
+  // Camera information is only parsed for the chosen frame
+  if (!findFrame(time_stamp, &frame_number, &frame_time_stamp) ||
+      !readFrame(frame_number, &img, &frame_time_stamp, &frame_meta))
+  {
+    return CalibratedImage();
+  }
+  const IntrinsicParameters* camera_parameters =
+      frame_meta.has_camera_parameters() ? &frame_meta.camera_parameters() : nullptr;
+  const Pose3D* pose = frame_meta.has_pose() ? &frame_meta.pose() : nullptr;
+  if (!camera_model || !camera_model->matches(camera_parameters, pose))
+  {
+    camera_model = std::make_shared<CameraModel>(frame_meta);
+  }
+  return CalibratedImage(img, camera_model);
+}
+
+void SharedMemoryImageProvider::update()
+{
+  setOffset(header->time_offset.load());
+  uint64_t nb_published = header->nb_published.load(std::memory_order_acquire);
+  nb_frames = nb_published;
+  if (nb_published == 0)
+  {
+    return;
+  }
+  const uint8_t* slot = data + getFrameBusSlotsOffset() + ((nb_published - 1) % header->nb_slots) * header->slot_size;
+  end = ((const FrameSlotHeader*)slot)->time_stamp.load();
+}
+
+cv::Mat SharedMemoryImageProvider::getNextImg()
+{
+  while (true)
+  {
+    uint64_t nb_published = header->nb_published.load(std::memory_order_acquire);
+    if ((uint64_t)index < nb_published)
+    {
+      index = std::max((uint64_t)index, getOldestFrameNumber());
+      cv::Mat img;
+      uint64_t time_stamp;
+      bool success = readFrame(index, &img, &time_stamp, nullptr);
+      index++;
+      if (success)
+      {
+        update();
+        return img;
+      }
+    }
+    else if (header->closed.load())
+    {
+      throw std::runtime_error(HL_DEBUG + "Frame bus '" + bus_name + "' has been closed");
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+bool SharedMemoryImageProvider::isStreamFinished()
+{
+  return header->closed.load() && (uint64_t)index >= header->nb_published.load();
+}
+
+uint64_t SharedMemoryImageProvider::getFrameTimeStamp(uint64_t time_stamp) const
+{
+  uint64_t frame_number, frame_time_stamp;
+  if (!findFrame(time_stamp, &frame_number, &frame_time_stamp))
+  {
+    return 0;
+  }
+  return frame_time_stamp;
+}
+
+uint64_t SharedMemoryImageProvider::getStart() const
+{
+  uint64_t nb_published = header->nb_published.load(std::memory_order_acquire);
+  // Oldest frame still present in the ring, nothing can be retrieved before the first publication
+  for (uint64_t frame_number = getOldestFrameNumber(); frame_number < nb_published; frame_number++)
+  {
+    uint64_t frame_time_stamp;
+    if (readTimeStamp(frame_number, &frame_time_stamp))
+    {
+      return frame_time_stamp;
+    }
+  }
+  return std::numeric_limits<uint64_t>::max();
+}
+
+uint64_t SharedMemoryImageProvider::getEnd() const
+{
+  return end;
+}
+
+bool SharedMemoryImageProvider::readFrame(uint64_t frame_number, cv::Mat* img, uint64_t* time_stamp,
+                                          CameraMetaInformation* camera_meta) const
+{
+  const uint8_t* slot = data + getFrameBusSlotsOffset() + (frame_number % header->nb_slots) * header->slot_size;
+  const FrameSlotHeader* slot_header = (const FrameSlotHeader*)slot;
+  uint64_t expected_sequence = 2 * frame_number + 2;
+  if (slot_header->sequence.load(std::memory_order_acquire) != expected_sequence)
+  {
+    return false;
+  }
+  *time_stamp = slot_header->time_stamp.load(std::memory_order_relaxed);
+  if (camera_meta != nullptr)
+  {
+    uint32_t meta_size = std::min(slot_header->meta_size.load(std::memory_order_relaxed), header->meta_capacity);
+    if (!camera_meta->ParseFromArray(slot + getFrameBusMetaOffset(), meta_size))
+    {
+      camera_meta->Clear();
+    }
+  }
+  // Mapping is read-only, image is not supposed to be modified by the consumer
+  *img = cv::Mat(header->img_height, header->img_width, header->img_type,
+                 (void*)(slot + getFrameBusImageOffset(header->meta_capacity)), header->img_step);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot_header->sequence.load(std::memory_order_relaxed) == expected_sequence;
+}
+
+bool SharedMemoryImageProvider::readTimeStamp(uint64_t frame_number, uint64_t* time_stamp) const
+{
+  const uint8_t* slot = data + getFrameBusSlotsOffset() + (frame_number % header->nb_slots) * header->slot_size;
+  const FrameSlotHeader* slot_header = (const FrameSlotHeader*)slot;
+  uint64_t expected_sequence = 2 * frame_number + 2;
+  if (slot_header->sequence.load(std::memory_order_acquire) != expected_sequence)
+  {
+    return false;
+  }
+  *time_stamp = slot_header->time_stamp.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot_header->sequence.load(std::memory_order_relaxed) == expected_sequence;
+}
+
+bool SharedMemoryImageProvider::findFrame(uint64_t time_stamp, uint64_t* frame_number,
+                                          uint64_t* frame_time_stamp) const
+{
+  uint64_t nb_published = header->nb_published.load(std::memory_order_acquire);
+  // Going from the most recent frame to the oldest one
+  for (uint64_t candidate = nb_published; candidate > getOldestFrameNumber(); candidate--)
+  {
+    if (readTimeStamp(candidate - 1, frame_time_stamp) && *frame_time_stamp <= time_stamp)
+    {
+      *frame_number = candidate - 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t SharedMemoryImageProvider::getOldestFrameNumber() const
+{
+  uint64_t nb_published = header->nb_published.load(std::memory_order_acquire);
+  // The slot of the oldest frame might be currently written
+  if (nb_published < header->nb_slots)
+  {
+    return 0;
+  }
+  return nb_published - header->nb_slots + 1;
+}
+
+}  // namespace hl_monitoring
@@ -1,12 +1,29 @@
 set(SOURCES
   calibrated_image.cpp
+  camera_model.cpp
+  clock_synchronizer.cpp
+  encoder_settings.cpp
   field.cpp
+  field_overlay_cache.cpp
+  frame_index.cpp
   top_view_drawer.cpp
+  top_view_mosaic.cpp
   image_provider.cpp
+  meta_information_reader.cpp
+  meta_information_writer.cpp
   monitoring_manager.cpp
   opencv_image_provider.cpp
+  pose_timeline.cpp
+  pose_tracker.cpp
+  projection_kernel.cpp
+  rectifier.cpp
+  replay_buffer.cpp
   replay_image_provider.cpp
+  shared_memory_frame_bus.cpp
+  shared_memory_image_provider.cpp
+  status_cursor.cpp
   utils.cpp
+  video_time_stamps.cpp
   )
 
 if (HL_MONITORING_USES_FLYCAPTURE)
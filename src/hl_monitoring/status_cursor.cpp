@@ -0,0 +1,148 @@
+#include "hl_monitoring/status_cursor.h"
+
+#include <algorithm>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+StatusCursor::StatusCursor(MessageManager* manager_) : manager(manager_), nb_rebuilds(0)
+{
+  reset();
+}
+
+const MessageManager::Status& StatusCursor::getStatus(uint64_t time_stamp)
+{
+  if (!has_timeline || manager->getEnd() != timeline_end)
+  {
+    loadNewMessages();
+  }
+  int64_t offset = manager->getOffset();
+  // Same conversion as MessageManager::getStatus
+  uint64_t message_time = time_stamp;
+  if (offset < 0 && time_stamp < (uint64_t)(-offset))
+  {
+    message_time = 0;
+  }
+  else
+  {
+    message_time += offset;
+  }
+  if (!has_status || offset != status_offset || message_time < status_message_time)
+  {
+    rebuild(message_time);
+  }
+  else
+  {
+    while (next_event < timeline.size() && timeline[next_event].time_stamp <= message_time)
+    {
+      apply(timeline[next_event]);
+      next_event++;
+    }
+  }
+  has_status = true;
+  status_message_time = message_time;
+  status_offset = offset;
+  return status;
+}
+
+void StatusCursor::reset()
+{
+  messages.Clear();
+  timeline.clear();
+  timeline_end = 0;
+  has_timeline = false;
+  next_event = 0;
+  status = MessageManager::Status();
+  has_status = false;
+  status_message_time = 0;
+  status_offset = 0;
+}
+
+size_t StatusCursor::getNbRebuilds() const
+{
+  return nb_rebuilds;
+}
+
+void StatusCursor::loadNewMessages()
+{
+  const GameMsgCollection& manager_messages = manager->getMessages();
+  if (manager_messages.gc_msg_size() < messages.gc_msg_size() ||
+      manager_messages.robot_msg_size() < messages.robot_msg_size())
+  {
+    // Messages have been removed from the manager: starting from scratch
+    reset();
+  }
+  std::vector<Event> new_events;
+  for (int idx = messages.gc_msg_size(); idx < manager_messages.gc_msg_size(); idx++)
+  {
+    messages.add_gc_msg()->CopyFrom(manager_messages.gc_msg(idx));
+    new_events.push_back({ manager_messages.gc_msg(idx).time_stamp(), true, idx });
+  }
+  for (int idx = messages.robot_msg_size(); idx < manager_messages.robot_msg_size(); idx++)
+  {
+    messages.add_robot_msg()->CopyFrom(manager_messages.robot_msg(idx));
+    new_events.push_back({ manager_messages.robot_msg(idx).time_stamp(), false, idx });
+  }
+  std::stable_sort(new_events.begin(), new_events.end(),
+                   [](const Event& e1, const Event& e2) { return e1.time_stamp < e2.time_stamp; });
+  for (const Event& event : new_events)
+  {
+    // Live messages are usually more recent than all the others: appended without moving the timeline
+    auto it = std::upper_bound(timeline.begin(), timeline.end(), event.time_stamp,
+                               [](uint64_t time_stamp, const Event& e) { return time_stamp < e.time_stamp; });
+    size_t position = it - timeline.begin();
+    timeline.insert(it, event);
+    if (has_status && event.time_stamp <= status_message_time)
+    {
+      // Message is older than the current position of the cursor
+      apply(event);
+      next_event++;
+    }
+    else if (position < next_event)
+    {
+      next_event++;
+    }
+  }
+  timeline_end = manager->getEnd();
+  has_timeline = true;
+}
+
+void StatusCursor::rebuild(uint64_t message_time)
+{
+  status = MessageManager::Status();
+  next_event = 0;
+  while (next_event < timeline.size() && timeline[next_event].time_stamp <= message_time)
+  {
+    apply(timeline[next_event]);
+    next_event++;
+  }
+  nb_rebuilds++;
+}
+
+void StatusCursor::apply(const Event& event)
+{
+  if (event.is_gc_msg)
+  {
+    const GCMsg& gc_msg = messages.gc_msg(event.msg_index);
+    if (status.gc_message.time_stamp() <= gc_msg.time_stamp())
+    {
+      status.gc_message.CopyFrom(gc_msg);
+    }
+  }
+  else
+  {
+    const RobotMsg& robot_msg = messages.robot_msg(event.msg_index);
+    auto it = status.robot_messages.find(robot_msg.robot_id());
+    if (it == status.robot_messages.end())
+    {
+      status.robot_messages[robot_msg.robot_id()].CopyFrom(robot_msg);
+    }
+    else if (it->second.time_stamp() <= robot_msg.time_stamp())
+    {
+      it->second.CopyFrom(robot_msg);
+    }
+  }
+}
+
+}  // namespace hl_monitoring
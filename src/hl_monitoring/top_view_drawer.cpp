@@ -2,6 +2,8 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include <cmath>
+
 namespace hl_monitoring
 {
 TopViewDrawer::TopViewDrawer() : TopViewDrawer(cv::Size(600, 400))
@@ -13,19 +15,56 @@ TopViewDrawer::TopViewDrawer(const cv::Size& img_size)
   , field_color(0, 255, 0)
   , lines_color(255, 255, 255)
   , goals_color(255, 0, 255)
+  , ball_color(0, 128, 255)
+  , has_background(false)
 {
 }
 
 cv::Mat TopViewDrawer::getImg(const Field& f) const
 {
-  cv::Mat result(img_size, CV_8UC3, background_color);
-  drawLines(f, &result);
-  drawCenter(f, &result);
-  drawPenaltyMarks(f, &result);
-  drawGoals(f, &result);
+  cv::Mat result;
+  getImg(f, &result);
   return result;
 }
 
+void TopViewDrawer::getImg(const Field& f, cv::Mat* dst) const
+{
+  updateBackground(f);
+  background.copyTo(*dst);
+}
+
+void TopViewDrawer::drawRobot(const Field& f, const cv::Point2f& pos_in_field, const cv::Scalar& color,
+                              cv::Mat* dst) const
+{
+  double scale = getScale(f);
+  // Robots are drawn with a fixed radius of 20cm
+  int radius = std::max(1, (int)(0.2 * scale));
+  cv::circle(*dst, toImg(scale, pos_in_field), radius, color, cv::FILLED);
+}
+
+void TopViewDrawer::drawRobot(const Field& f, const cv::Point2f& pos_in_field, double orientation,
+                              const cv::Scalar& color, cv::Mat* dst) const
+{
+  drawRobot(f, pos_in_field, color, dst);
+  double scale = getScale(f);
+  cv::Point2f dir(std::cos(orientation), std::sin(orientation));
+  cv::line(*dst, toImg(scale, pos_in_field), toImg(scale, pos_in_field + 0.4 * dir), color,
+           std::max(1, getLineWidth(f)));
+}
+
+void TopViewDrawer::drawBall(const Field& f, const cv::Point2f& pos_in_field, cv::Mat* dst) const
+{
+  double scale = getScale(f);
+  int radius = std::max(1, (int)(f.ball_radius * scale));
+  cv::circle(*dst, toImg(scale, pos_in_field), radius, ball_color, cv::FILLED);
+}
+
+void TopViewDrawer::drawAnnotation(const Field& f, const cv::Point2f& pos_in_field, const std::string& text,
+                                   const cv::Scalar& color, cv::Mat* dst) const
+{
+  cv::putText(*dst, text, getImgFromField(f, pos_in_field), cv::FONT_HERSHEY_SIMPLEX, 0.5, color);
+}
+
 double TopViewDrawer::getScale(const Field& f) const
 {
   double scale_x = img_size.width / f.getArenaLength();
@@ -39,9 +78,57 @@ cv::Point TopViewDrawer::getImgFromField(const Field& f, const cv::Point3f& pos_
 }
 
 cv::Point TopViewDrawer::getImgFromField(const Field& f, const cv::Point2f& pos_in_field) const
+{
+  return toImg(getScale(f), pos_in_field);
+}
+
+cv::Point2f TopViewDrawer::getFieldFromImg(const Field& f, const cv::Point2f& pos_in_img) const
+{
+  cv::Point2f center(img_size.width / 2, img_size.height / 2);
+  return (pos_in_img - center) / getScale(f);
+}
+
+const cv::Size& TopViewDrawer::getImgSize() const
+{
+  return img_size;
+}
+
+bool TopViewDrawer::isBackgroundUpToDate(const Field& f) const
+{
+  const BackgroundKey& key = background_key;
+  return has_background && key.arena_length == f.getArenaLength() && key.arena_width == f.getArenaWidth() &&
+         key.line_width == f.line_width && key.center_radius == f.center_radius &&
+         key.penalty_mark_length == f.penalty_mark_length && key.white_lines == f.getWhiteLines() &&
+         key.goals == f.getGoals() && key.penalty_marks == f.getPenaltyMarks();
+}
+
+void TopViewDrawer::updateBackground(const Field& f) const
+{
+  if (isBackgroundUpToDate(f))
+  {
+    return;
+  }
+  background.create(img_size, CV_8UC3);
+  background.setTo(background_color);
+  drawLines(f, &background);
+  drawCenter(f, &background);
+  drawPenaltyMarks(f, &background);
+  drawGoals(f, &background);
+  background_key.arena_length = f.getArenaLength();
+  background_key.arena_width = f.getArenaWidth();
+  background_key.line_width = f.line_width;
+  background_key.center_radius = f.center_radius;
+  background_key.penalty_mark_length = f.penalty_mark_length;
+  background_key.white_lines = f.getWhiteLines();
+  background_key.goals = f.getGoals();
+  background_key.penalty_marks = f.getPenaltyMarks();
+  has_background = true;
+}
+
+cv::Point TopViewDrawer::toImg(double scale, const cv::Point2f& pos_in_field) const
 {
   cv::Point2f center(img_size.width / 2, img_size.height / 2);
-  return center + pos_in_field * getScale(f);
+  return center + pos_in_field * scale;
 }
 
 int TopViewDrawer::getLineWidth(const Field& f) const
@@ -68,11 +155,13 @@ void TopViewDrawer::drawTurf(const Field& f, cv::Mat* dst) const
 
 void TopViewDrawer::drawLines(const Field& f, cv::Mat* dst) const
 {
+  double scale = getScale(f);
+  int line_width = getLineWidth(f);
   for (const Field::Segment& line : f.getWhiteLines())
   {
-    cv::Point pt1 = getImgFromField(f, line.first);
-    cv::Point pt2 = getImgFromField(f, line.second);
-    cv::line(*dst, pt1, pt2, lines_color, getLineWidth(f));
+    cv::Point pt1 = toImg(scale, cv::Point2f(line.first.x, line.first.y));
+    cv::Point pt2 = toImg(scale, cv::Point2f(line.second.x, line.second.y));
+    cv::line(*dst, pt1, pt2, lines_color, line_width);
   }
 }
 
@@ -86,11 +175,13 @@ void TopViewDrawer::drawPenaltyMarks(const Field& f, cv::Mat* dst) const
 
 void TopViewDrawer::drawGoals(const Field& f, cv::Mat* dst) const
 {
+  double scale = getScale(f);
+  int goal_width = getGoalWidth(f);
   for (const Field::Segment& goal : f.getGoals())
   {
-    cv::Point pt1 = getImgFromField(f, goal.first);
-    cv::Point pt2 = getImgFromField(f, goal.second);
-    cv::line(*dst, pt1, pt2, goals_color, getGoalWidth(f));
+    cv::Point pt1 = toImg(scale, cv::Point2f(goal.first.x, goal.first.y));
+    cv::Point pt2 = toImg(scale, cv::Point2f(goal.second.x, goal.second.y));
+    cv::line(*dst, pt1, pt2, goals_color, goal_width);
   }
 }
 
@@ -0,0 +1,170 @@
+#include "hl_monitoring/top_view_mosaic.h"
+
+#include <hl_communication/utils.h>
+
+#include <opencv2/imgproc.hpp>
+
+namespace hl_monitoring
+{
+TopViewMosaic::TopViewMosaic()
+{
+}
+
+TopViewMosaic::TopViewMosaic(const TopViewDrawer& drawer_) : drawer(drawer_)
+{
+}
+
+cv::Mat TopViewMosaic::getImg(const Field& f, const std::map<std::string, CalibratedImage>& images)
+{
+  cv::Mat result;
+  getImg(f, images, &result);
+  return result;
+}
+
+void TopViewMosaic::getImg(const Field& f, const std::map<std::string, CalibratedImage>& images, cv::Mat* dst)
+{
+  std::vector<WarpTable*> active_tables;
+  std::vector<const cv::Mat*> sources;
+  for (const auto& entry : images)
+  {
+    const CalibratedImage& calib_img = entry.second;
+    const cv::Mat& img = calib_img.getImg();
+    if (!calib_img.isFullySpecified() || img.empty())
+    {
+      continue;
+    }
+    if (img.type() != CV_8UC3)
+    {
+      throw std::runtime_error(HL_DEBUG + "unsupported image type for '" + entry.first + "', expecting CV_8UC3");
+    }
+    WarpTable& table = tables[entry.first];
+    if (!isUpToDate(table, f, calib_img.getSharedCameraModel()))
+    {
+      updateTable(f, calib_img.getSharedCameraModel(), &table);
+    }
+    active_tables.push_back(&table);
+    sources.push_back(&img);
+  }
+
+  // Warping cameras in parallel, each table owns its output buffer
+  cv::parallel_for_(cv::Range(0, (int)active_tables.size()), [&](const cv::Range& range) {
+    for (int idx = range.start; idx < range.end; idx++)
+    {
+      WarpTable* table = active_tables[idx];
+      cv::remap(*sources[idx], table->warped, table->map1, table->map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+    }
+  });
+
+  // Blending: average of all cameras seeing a pixel, synthetic view elsewhere
+  drawer.getImg(f, dst);
+  const cv::Size& size = drawer.getImgSize();
+  sum.create(size, CV_16UC3);
+  count.create(size, CV_8UC1);
+  sum.setTo(cv::Scalar::all(0));
+  count.setTo(cv::Scalar::all(0));
+  for (const WarpTable* table : active_tables)
+  {
+    for (int row = 0; row < size.height; row++)
+    {
+      const uint8_t* mask_ptr = table->mask.ptr<uint8_t>(row);
+      const uint8_t* warped_ptr = table->warped.ptr<uint8_t>(row);
+      uint16_t* sum_ptr = sum.ptr<uint16_t>(row);
+      uint8_t* count_ptr = count.ptr<uint8_t>(row);
+      for (int col = 0; col < size.width; col++)
+      {
+        if (mask_ptr[col])
+        {
+          sum_ptr[3 * col] += warped_ptr[3 * col];
+          sum_ptr[3 * col + 1] += warped_ptr[3 * col + 1];
+          sum_ptr[3 * col + 2] += warped_ptr[3 * col + 2];
+          count_ptr[col]++;
+        }
+      }
+    }
+  }
+  for (int row = 0; row < size.height; row++)
+  {
+    const uint16_t* sum_ptr = sum.ptr<uint16_t>(row);
+    const uint8_t* count_ptr = count.ptr<uint8_t>(row);
+    uint8_t* dst_ptr = dst->ptr<uint8_t>(row);
+    for (int col = 0; col < size.width; col++)
+    {
+      int nb_views = count_ptr[col];
+      if (nb_views > 0)
+      {
+        for (int channel = 0; channel < 3; channel++)
+        {
+          dst_ptr[3 * col + channel] = (uint8_t)(sum_ptr[3 * col + channel] / nb_views);
+        }
+      }
+    }
+  }
+}
+
+const TopViewDrawer& TopViewMosaic::getDrawer() const
+{
+  return drawer;
+}
+
+void TopViewMosaic::clear()
+{
+  tables.clear();
+}
+
+bool TopViewMosaic::isUpToDate(const WarpTable& table, const Field& f,
+                               const std::shared_ptr<const CameraModel>& camera_model) const
+{
+  if (!table.camera_model || table.scale != drawer.getScale(f))
+  {
+    return false;
+  }
+  // Providers share models among frames: comparing parameters is rarely required
+  if (table.camera_model == camera_model)
+  {
+    return true;
+  }
+  const CameraMetaInformation& camera_meta = camera_model->getCameraInformation();
+  return table.camera_model->matches(camera_meta.has_camera_parameters() ? &camera_meta.camera_parameters() : nullptr,
+                                     camera_meta.has_pose() ? &camera_meta.pose() : nullptr);
+}
+
+void TopViewMosaic::updateTable(const Field& f, const std::shared_ptr<const CameraModel>& camera_model,
+                                WarpTable* table) const
+{
+  const cv::Size& size = drawer.getImgSize();
+  std::vector<cv::Point3f> pos_in_field;
+  pos_in_field.reserve(size.area());
+  for (int row = 0; row < size.height; row++)
+  {
+    for (int col = 0; col < size.width; col++)
+    {
+      cv::Point2f ground_pos = drawer.getFieldFromImg(f, cv::Point2f(col, row));
+      pos_in_field.push_back(cv::Point3f(ground_pos.x, ground_pos.y, 0));
+    }
+  }
+  std::vector<cv::Point2f> pos_in_img;
+  std::vector<uint8_t> visible;
+  camera_model->fieldToImg(pos_in_field, &pos_in_img, &visible);
+
+  cv::Mat map_x(size, CV_32FC1), map_y(size, CV_32FC1);
+  table->mask.create(size, CV_8UC1);
+  for (int row = 0; row < size.height; row++)
+  {
+    float* x_ptr = map_x.ptr<float>(row);
+    float* y_ptr = map_y.ptr<float>(row);
+    uint8_t* mask_ptr = table->mask.ptr<uint8_t>(row);
+    for (int col = 0; col < size.width; col++)
+    {
+      size_t idx = row * size.width + col;
+      // Pixels not seen by the camera are sent outside of the image
+      mask_ptr[col] = visible[idx] ? 255 : 0;
+      x_ptr[col] = visible[idx] ? pos_in_img[idx].x : -1;
+      y_ptr[col] = visible[idx] ? pos_in_img[idx].y : -1;
+    }
+  }
+  cv::convertMaps(map_x, map_y, table->map1, table->map2, CV_16SC2);
+  table->camera_model = camera_model;
+  table->scale = drawer.getScale(f);
+}
+
+}  // namespace hl_monitoring
@@ -75,14 +75,31 @@ cv::Point2f fieldToImg(const cv::Point3f& pos_in_field, const CameraMetaInformat
   {
     throw std::runtime_error(HL_DEBUG + " camera_information is not fully specified");
   }
-  cv::Mat camera_matrix, distortion_coeffs, rvec, tvec;
-  cv::Size size;
-  intrinsicToCV(camera_information.camera_parameters(), &camera_matrix, &distortion_coeffs, &size);
-  pose3DToCV(camera_information.pose(), &rvec, &tvec);
-  std::vector<cv::Point3f> object_points = { pos_in_field };
-  std::vector<cv::Point2f> img_points;
-  cv::projectPoints(object_points, rvec, tvec, camera_matrix, distortion_coeffs, img_points);
-  return img_points[0];
+  return CameraModel(camera_information).fieldToImg(pos_in_field);
+}
+
+cv::Point2f fieldToImg(const cv::Point3f& pos_in_field, const CameraModel& camera_model)
+{
+  return camera_model.fieldToImg(pos_in_field);
+}
+
+void fieldToImg(const std::vector<cv::Point3f>& pos_in_field, const std::map<std::string, CalibratedImage>& images,
+                std::map<std::string, std::vector<cv::Point2f>>* pos_in_imgs,
+                std::map<std::string, std::vector<uint8_t>>* visible)
+{
+  for (const auto& entry : images)
+  {
+    if (!entry.second.isFullySpecified())
+    {
+      continue;
+    }
+    std::vector<uint8_t>* camera_visible = nullptr;
+    if (visible != nullptr)
+    {
+      camera_visible = &((*visible)[entry.first]);
+    }
+    entry.second.getCameraModel().fieldToImg(pos_in_field, &((*pos_in_imgs)[entry.first]), camera_visible);
+  }
 }
 
 void checkMember(const Json::Value& v, const std::string& key)
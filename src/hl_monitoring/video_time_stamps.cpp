@@ -0,0 +1,89 @@
+#include "hl_monitoring/video_time_stamps.h"
+
+#include <hl_communication/utils.h>
+
+#ifdef HL_MONITORING_USES_LIBAV
+extern "C" {
+#include <libavformat/avformat.h>
+}
+#else
+#include <hl_monitoring/encoder_settings.h>
+
+#include <opencv2/videoio.hpp>
+#endif
+
+#include <algorithm>
+
+namespace hl_monitoring
+{
+/**
+ * Sort time_stamps and express them relatively to the first one
+ */
+static std::vector<uint64_t> toRelativeTimeStamps(std::vector<int64_t>* time_stamps)
+{
+  std::sort(time_stamps->begin(), time_stamps->end());
+  std::vector<uint64_t> result;
+  result.reserve(time_stamps->size());
+  for (int64_t time_stamp : *time_stamps)
+  {
+    result.push_back(time_stamp - time_stamps->front());
+  }
+  return result;
+}
+
+#ifdef HL_MONITORING_USES_LIBAV
+std::vector<uint64_t> readVideoTimeStamps(const std::string& video_path)
+{
+  AVFormatContext* context = nullptr;
+  if (avformat_open_input(&context, video_path.c_str(), nullptr, nullptr) < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open video '" + video_path + "'");
+  }
+  int stream_index = av_find_best_stream(context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+  if (stream_index < 0)
+  {
+    avformat_close_input(&context);
+    throw std::runtime_error(HL_DEBUG + "No video stream in '" + video_path + "'");
+  }
+  AVRational time_base = context->streams[stream_index]->time_base;
+  AVRational microseconds = { 1, 1000000 };
+  std::vector<int64_t> time_stamps;
+  AVPacket* packet = av_packet_alloc();
+  // Demuxing only: packets are never sent to a decoder
+  while (av_read_frame(context, packet) >= 0)
+  {
+    if (packet->stream_index == stream_index)
+    {
+      int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+      if (pts != AV_NOPTS_VALUE)
+      {
+        time_stamps.push_back(av_rescale_q(pts, time_base, microseconds));
+      }
+    }
+    av_packet_unref(packet);
+  }
+  av_packet_free(&packet);
+  avformat_close_input(&context);
+  return toRelativeTimeStamps(&time_stamps);
+}
+#else
+std::vector<uint64_t> readVideoTimeStamps(const std::string& video_path)
+{
+  cv::VideoCapture video;
+  std::unique_lock<std::mutex> lock = lockVideoEnvironment();
+  if (!video.open(video_path))
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open video '" + video_path + "'");
+  }
+  lock.unlock();
+  std::vector<int64_t> time_stamps;
+  // grab avoids the conversion of the frames but still decodes them
+  while (video.grab())
+  {
+    time_stamps.push_back((int64_t)(video.get(cv::CAP_PROP_POS_MSEC) * 1000));
+  }
+  return toRelativeTimeStamps(&time_stamps);
+}
+#endif
+
+}  // namespace hl_monitoring
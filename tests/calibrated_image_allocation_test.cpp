@@ -0,0 +1,175 @@
+/**
+ * Checks that fetching calibrated images in a reused output does not allocate
+ * memory once the providers are initialized:
+ * - Updating the pose of a camera model does not allocate
+ * - A tick of MonitoringManager on replay providers with a pose per frame does
+ *   not allocate as long as no new frame has to be decoded
+ * - Camera models are updated in place when the pose changes between frames
+ *   instead of being rebuilt
+ */
+#include "allocation_counter.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/meta_information_writer.h>
+#include <hl_monitoring/monitoring_manager.h>
+#include <hl_monitoring/replay_image_provider.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <cstdio>
+#include <iostream>
+
+using namespace hl_communication;
+using namespace hl_monitoring;
+
+static Pose3D buildPose(int frame_idx)
+{
+  Pose3D pose;
+  pose.add_rotation(2.0 + 0.01 * frame_idx);
+  pose.add_rotation(0.05);
+  pose.add_rotation(-0.02 * frame_idx);
+  pose.add_translation(0.1 * frame_idx);
+  pose.add_translation(0.5);
+  pose.add_translation(4.0);
+  return pose;
+}
+
+int main()
+{
+  if (!isCountingAllocations())
+  {
+    std::cout << "Allocations are not counted on this platform, skipping test" << std::endl;
+    return EXIT_SUCCESS;
+  }
+  int nb_errors = 0;
+
+  // Updating the pose of a model
+  CameraMetaInformation camera_meta;
+  IntrinsicParameters* intrinsic = camera_meta.mutable_camera_parameters();
+  intrinsic->set_focal_x(320);
+  intrinsic->set_focal_y(320);
+  intrinsic->set_center_x(160);
+  intrinsic->set_center_y(120);
+  intrinsic->set_img_width(320);
+  intrinsic->set_img_height(240);
+  for (double coeff : { -0.25, 0.08, 0.001, -0.0005, -0.01 })
+  {
+    intrinsic->add_distortion(coeff);
+  }
+  camera_meta.mutable_pose()->CopyFrom(buildPose(0));
+  CameraModel model(camera_meta);
+  std::vector<Pose3D> poses;
+  for (int idx = 0; idx < 10; idx++)
+  {
+    poses.push_back(buildPose(idx));
+  }
+  uint64_t nb_allocations = getNbAllocations();
+  for (const Pose3D& pose : poses)
+  {
+    model.setPose(pose);
+  }
+  if (getNbAllocations() != nb_allocations)
+  {
+    std::cerr << "CameraModel::setPose allocated " << (getNbAllocations() - nb_allocations) << " times" << std::endl;
+    nb_errors++;
+  }
+  if (!model.matches(&camera_meta.camera_parameters(), &poses.back()))
+  {
+    std::cerr << "CameraModel::setPose did not update the pose" << std::endl;
+    nb_errors++;
+  }
+
+  // Recording with a pose for each frame
+  std::string video_path = "calibrated_image_allocation_test.avi";
+  std::string meta_path = "calibrated_image_allocation_test.bin";
+  int nb_frames = 10;
+  uint64_t start = 1000 * 1000;
+  uint64_t frame_period = 33333;
+  {
+    cv::Size img_size(intrinsic->img_width(), intrinsic->img_height());
+    cv::VideoWriter video_writer(video_path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30, img_size);
+    if (!video_writer.isOpened())
+    {
+      throw std::runtime_error(HL_DEBUG + "failed to open video '" + video_path + "'");
+    }
+    VideoMetaInformation header;
+    header.mutable_camera_parameters()->CopyFrom(*intrinsic);
+    header.mutable_default_pose()->CopyFrom(buildPose(0));
+    MetaInformationWriter meta_writer(meta_path);
+    meta_writer.writeHeader(header);
+    cv::Mat img(img_size, CV_8UC3);
+    for (int frame_idx = 0; frame_idx < nb_frames; frame_idx++)
+    {
+      img.setTo(cv::Scalar(0, 100, 0));
+      cv::circle(img, cv::Point(20 + 20 * frame_idx, 120), 10, cv::Scalar(255, 255, 255), cv::FILLED);
+      video_writer.write(img);
+      FrameEntry frame;
+      frame.set_time_stamp(start + frame_idx * frame_period);
+      frame.mutable_pose()->CopyFrom(poses[frame_idx]);
+      meta_writer.writeFrame(frame);
+    }
+    meta_writer.close();
+  }
+
+  MonitoringManager manager;
+  std::vector<std::string> names = { "camera_1", "camera_2" };
+  for (const std::string& name : names)
+  {
+    std::unique_ptr<ImageProvider> provider(new ReplayImageProvider(video_path, meta_path));
+    manager.addImageProvider(name, std::move(provider));
+  }
+
+  // Initializing the buffers of the providers and of the output
+  std::map<std::string, CalibratedImage> images;
+  for (int frame_idx = 0; frame_idx < nb_frames; frame_idx++)
+  {
+    manager.getCalibratedImages(start + frame_idx * frame_period, &images);
+  }
+  std::map<std::string, const CameraModel*> models;
+  for (const std::string& name : names)
+  {
+    models[name] = images.at(name).getSharedCameraModel().get();
+  }
+
+  // Playback: the display runs faster than the video, each frame is requested
+  // multiple times and only the first request decodes it
+  int nb_ticks_per_frame = 4;
+  for (int frame_idx = 0; frame_idx < nb_frames; frame_idx++)
+  {
+    uint64_t frame_time_stamp = start + frame_idx * frame_period;
+    manager.getCalibratedImages(frame_time_stamp, &images);
+    for (const std::string& name : names)
+    {
+      const CalibratedImage& img = images.at(name);
+      if (img.getSharedCameraModel().get() != models[name] ||
+          !img.getCameraModel().matches(&camera_meta.camera_parameters(), &poses[frame_idx]))
+      {
+        std::cerr << "Camera model of " << name << " was rebuilt or has a wrong pose at frame " << frame_idx
+                  << std::endl;
+        nb_errors++;
+      }
+    }
+    nb_allocations = getNbAllocations();
+    for (int tick = 1; tick < nb_ticks_per_frame; tick++)
+    {
+      manager.getCalibratedImages(frame_time_stamp + tick * frame_period / nb_ticks_per_frame, &images);
+    }
+    if (getNbAllocations() != nb_allocations)
+    {
+      std::cerr << "Ticks at frame " << frame_idx << " allocated " << (getNbAllocations() - nb_allocations)
+                << " times" << std::endl;
+      nb_errors++;
+    }
+  }
+  std::remove(video_path.c_str());
+  std::remove(meta_path.c_str());
+  std::remove(FrameIndex::getIndexPath(meta_path).c_str());
+
+  if (nb_errors > 0)
+  {
+    std::cerr << nb_errors << " errors" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/**
+ * Checks that the status provided by StatusCursor matches the status provided
+ * by MessageManager for monotonic requests, backward seeks and offset changes,
+ * and that monotonic requests do not rebuild the status.
+ */
+#include <hl_communication/utils.h>
+#include <hl_monitoring/status_cursor.h>
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+using namespace hl_communication;
+using namespace hl_monitoring;
+
+static bool isSameStatus(const MessageManager::Status& s1, const MessageManager::Status& s2)
+{
+  if (s1.gc_message.SerializeAsString() != s2.gc_message.SerializeAsString() ||
+      s1.robot_messages.size() != s2.robot_messages.size())
+  {
+    return false;
+  }
+  auto it1 = s1.robot_messages.begin();
+  auto it2 = s2.robot_messages.begin();
+  for (; it1 != s1.robot_messages.end(); it1++, it2++)
+  {
+    if (it1->second.SerializeAsString() != it2->second.SerializeAsString())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main()
+{
+  std::mt19937 engine(42);
+  std::uniform_int_distribution<uint64_t> jitter(0, 20 * 1000);
+  GameMsgCollection messages;
+  uint64_t start = 1000 * 1000;
+  uint64_t duration = 60 * 1000 * 1000;
+  for (uint64_t time_stamp = start; time_stamp < start + duration; time_stamp += 500 * 1000)
+  {
+    GCMsg* gc_msg = messages.add_gc_msg();
+    gc_msg->set_time_stamp(time_stamp + jitter(engine));
+  }
+  for (uint32_t robot_id = 1; robot_id <= 4; robot_id++)
+  {
+    for (uint64_t time_stamp = start; time_stamp < start + duration; time_stamp += 100 * 1000)
+    {
+      RobotMsg* robot_msg = messages.add_robot_msg();
+      robot_msg->set_time_stamp(time_stamp + jitter(engine));
+      robot_msg->mutable_robot_id()->set_team_id(1);
+      robot_msg->mutable_robot_id()->set_robot_id(robot_id);
+    }
+  }
+  std::string path = "status_cursor_test_messages.bin";
+  writeToFile(path, messages);
+  MessageManager manager(path);
+  std::remove(path.c_str());
+  StatusCursor cursor(&manager);
+
+  // Monotonic replay, slower and faster than the messages
+  std::vector<uint64_t> monotonic_requests;
+  for (uint64_t time_stamp = 0; time_stamp < start + duration + 1000 * 1000; time_stamp += 33 * 1000)
+  {
+    monotonic_requests.push_back(time_stamp);
+  }
+  // Backward seeks and random accesses
+  std::vector<uint64_t> random_requests;
+  std::uniform_int_distribution<uint64_t> time_distrib(0, start + duration + 1000 * 1000);
+  for (int idx = 0; idx < 500; idx++)
+  {
+    random_requests.push_back(time_distrib(engine));
+  }
+  int nb_errors = 0;
+  for (int64_t offset : { (int64_t)0, (int64_t)2 * 1000 * 1000 })
+  {
+    manager.setOffset(offset);
+    for (const std::vector<uint64_t>* requests : { &monotonic_requests, &random_requests })
+    {
+      size_t nb_rebuilds = cursor.getNbRebuilds();
+      for (uint64_t time_stamp : *requests)
+      {
+        if (!isSameStatus(cursor.getStatus(time_stamp), manager.getStatus(time_stamp)))
+        {
+          std::cerr << "Status mismatch at " << time_stamp << " with offset " << offset << std::endl;
+          nb_errors++;
+        }
+      }
+      // Only the first request can rebuild: offset changed or seek back to the beginning
+      if (requests == &monotonic_requests && cursor.getNbRebuilds() > nb_rebuilds + 1)
+      {
+        std::cerr << "Monotonic requests with offset " << offset << " rebuilt the status "
+                  << (cursor.getNbRebuilds() - nb_rebuilds) << " times" << std::endl;
+        nb_errors++;
+      }
+    }
+  }
+  if (nb_errors > 0)
+  {
+    std::cerr << nb_errors << " errors" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
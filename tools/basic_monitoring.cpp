@@ -6,7 +6,9 @@
  */
 #include <hl_communication/utils.h>
 #include <hl_monitoring/field.h>
+#include <hl_monitoring/field_overlay_cache.h>
 #include <hl_monitoring/monitoring_manager.h>
+#include <hl_monitoring/top_view_mosaic.h>
 #include <hl_monitoring/utils.h>
 
 #include <opencv2/imgproc.hpp>
@@ -25,6 +27,8 @@ int main(int argc, char** argv)
   TCLAP::ValueArg<std::string> field_arg("f", "field", "The path to the json description of the file", true,
                                          "field.json", "string");
   TCLAP::SwitchArg verbose_arg("v", "verbose", "If enabled display all messages received", cmd, false);
+  TCLAP::SwitchArg mosaic_arg("m", "mosaic", "If enabled display a top view built from all calibrated cameras", cmd,
+                              false);
   cmd.add(config_arg);
   cmd.add(field_arg);
 
@@ -44,6 +48,16 @@ int main(int argc, char** argv)
   Field field;
   field.loadFile(field_arg.getValue());
 
+  // Buffers used for annotation, reused between iterations
+  std::vector<cv::Point3f> robots_in_field;
+  std::vector<cv::Scalar> robots_colors;
+  std::map<std::string, std::vector<cv::Point2f>> robots_in_imgs;
+  std::map<std::string, std::vector<uint8_t>> robots_visible;
+  FieldOverlayCache overlay_cache;
+  TopViewMosaic mosaic;
+  cv::Mat mosaic_img;
+  std::map<std::string, CalibratedImage> images_by_source;
+
   // While exit was not explicitly required, run
   uint64_t now = 0;
   uint64_t dt = 30 * 1000;  //[microseconds]
@@ -66,7 +80,7 @@ int main(int argc, char** argv)
     }
     int64_t post_manager_update = getTimeStamp();
 
-    MessageManager::Status status = manager.getStatus(now);
+    const MessageManager::Status& status = manager.getStatus(now);
     std::vector<cv::Scalar> team_colors = { cv::Scalar(255, 255, 0), cv::Scalar(255, 0, 255) };
     std::map<uint32_t, cv::Scalar> colors_by_team;
     for (int idx = 0; idx < status.gc_message.teams_size(); idx++)
@@ -94,47 +108,68 @@ int main(int argc, char** argv)
       }
     }
 
-    std::map<std::string, CalibratedImage> images_by_source = manager.getCalibratedImages(now);
+    manager.getCalibratedImages(now, &images_by_source);
     int64_t post_get_images = getTimeStamp();
 
+    // Gathering all robot estimated positions to project them in a single call per camera
+    robots_in_field.clear();
+    robots_colors.clear();
+    for (const auto& robot_entry : status.robot_messages)
+    {
+      uint32_t team_id = robot_entry.first.team_id();
+      cv::Scalar color = cv::Scalar(0, 0, 0);
+      if (colors_by_team.count(team_id) == 0)
+      {
+        std::cerr << "Unknown color for team " << team_id << ": using black (default)" << std::endl;
+      }
+      else
+      {
+        color = colors_by_team[team_id];
+      }
+      if (robot_entry.second.has_perception())
+      {
+        const Perception& perception = robot_entry.second.perception();
+        for (int pos_idx = 0; pos_idx < perception.self_in_field_size(); pos_idx++)
+        {
+          const PositionDistribution& position = perception.self_in_field(pos_idx).pose().position();
+          robots_in_field.push_back(cv::Point3f(position.x(), position.y(), 0.0));
+          robots_colors.push_back(color);
+        }
+      }
+    }
+    fieldToImg(robots_in_field, images_by_source, &robots_in_imgs, &robots_visible);
+
     for (const auto& entry : images_by_source)
     {
       cv::Mat display_img = entry.second.getImg().clone();
       if (entry.second.isFullySpecified())
       {
-        const CameraMetaInformation& camera_information = entry.second.getCameraInformation();
-        field.tagLines(camera_information, &display_img, cv::Scalar(0, 0, 0), 1, 10);
+        overlay_cache.tagLines(entry.first, field, entry.second.getSharedCameraModel(), &display_img,
+                               cv::Scalar(0, 0, 0), 1, 10);
         // Basic drawing of robot estimated position
-        for (const auto& robot_entry : status.robot_messages)
+        const std::vector<cv::Point2f>& pos_in_img = robots_in_imgs[entry.first];
+        const std::vector<uint8_t>& visible = robots_visible[entry.first];
+        for (size_t idx = 0; idx < robots_in_field.size(); idx++)
         {
-          uint32_t team_id = robot_entry.first.team_id();
-          cv::Scalar color = cv::Scalar(0, 0, 0);
-          if (colors_by_team.count(team_id) == 0)
-          {
-            std::cerr << "Unknown color for team " << team_id << ": using black (default)" << std::endl;
-          }
-          else
-          {
-            color = colors_by_team[team_id];
-          }
-          if (robot_entry.second.has_perception())
+          if (visible[idx])
           {
-            const Perception& perception = robot_entry.second.perception();
-            for (int pos_idx = 0; pos_idx < perception.self_in_field_size(); pos_idx++)
-            {
-              const WeightedPose& weighted_pose = perception.self_in_field(pos_idx);
-              const PositionDistribution& position = weighted_pose.pose().position();
-              cv::Point3f pos_in_field(position.x(), position.y(), 0.0);
-              cv::Point2f pos_in_img = fieldToImg(pos_in_field, camera_information);
-              int circle_size = 10;
-              cv::circle(display_img, pos_in_img, circle_size, color, cv::FILLED);
-              double angle = weighted_pose.pose().dir().mean();
-            }
+            int circle_size = 10;
+            cv::circle(display_img, pos_in_img[idx], circle_size, robots_colors[idx], cv::FILLED);
           }
         }
       }
       cv::imshow(entry.first, display_img);
     }
+    if (mosaic_arg.getValue())
+    {
+      mosaic.getImg(field, images_by_source, &mosaic_img);
+      for (size_t idx = 0; idx < robots_in_field.size(); idx++)
+      {
+        cv::Point2f robot_pos(robots_in_field[idx].x, robots_in_field[idx].y);
+        mosaic.getDrawer().drawRobot(field, robot_pos, robots_colors[idx], &mosaic_img);
+      }
+      cv::imshow("top_view", mosaic_img);
+    }
     int64_t post_annotation = getTimeStamp();
     char key = cv::waitKey(1);
     if (key == 'q' || key == 'Q')
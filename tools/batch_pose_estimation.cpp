@@ -0,0 +1,159 @@
+/**
+ * Estimate the pose of the camera for every frame of a recorded video by
+ * tracking the white lines of the field.
+ *
+ * The video is split in chunks of consecutive frames processed in parallel.
+ * Each worker owns its own video reader, seeks to the beginning of the chunk
+ * and starts tracking from the default pose of the meta information. Poses
+ * successfully refined are written in the frame entries of a new meta
+ * information file, other frames keep no pose and are interpolated at replay.
+ */
+#include <hl_communication/utils.h>
+#include <hl_monitoring/field.h>
+#include <hl_monitoring/meta_information_reader.h>
+#include <hl_monitoring/pose_tracker.h>
+#include <hl_monitoring/replay_image_provider.h>
+
+#include <tclap/CmdLine.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace hl_communication;
+using namespace hl_monitoring;
+
+int main(int argc, char** argv)
+{
+  TCLAP::CmdLine cmd("Estimate the pose of the camera for all the frames of a video", ' ', "0.9");
+
+  TCLAP::ValueArg<std::string> video_arg("v", "video", "The path to the video", true, "video.avi", "path", cmd);
+  TCLAP::ValueArg<std::string> meta_arg("m", "meta", "The path to the meta information of the video", true,
+                                        "meta.bin", "path", cmd);
+  TCLAP::ValueArg<std::string> field_arg("f", "field", "The path to the json description of the field", true,
+                                         "field.json", "path", cmd);
+  TCLAP::ValueArg<std::string> output_arg("o", "output", "The output path for the meta information", true,
+                                          "meta_with_poses.bin", "path", cmd);
+  TCLAP::ValueArg<int> threads_arg("j", "threads", "Number of worker threads (0: number of cores)", false, 0, "int",
+                                   cmd);
+  TCLAP::ValueArg<int> chunk_arg("c", "chunk_size", "Number of consecutive frames processed by a worker", false, 500,
+                                 "int", cmd);
+  try
+  {
+    cmd.parse(argc, argv);
+  }
+  catch (const TCLAP::ArgException& e)
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Reading all the frame entries once, workers only need the header
+  MetaInformationReader reader(meta_arg.getValue());
+  VideoMetaInformation meta_information;
+  meta_information.CopyFrom(reader.getHeader());
+  meta_information.mutable_frames()->Reserve(reader.getNbFrames());
+  while (reader.readNextFrame(meta_information.add_frames()))
+  {
+  }
+  meta_information.mutable_frames()->RemoveLast();
+  if (!meta_information.has_camera_parameters() || !meta_information.has_default_pose())
+  {
+    throw std::runtime_error(HL_DEBUG + "meta information requires camera parameters and a default pose");
+  }
+
+  Field field;
+  field.loadFile(field_arg.getValue());
+
+  int nb_video_frames = ReplayImageProvider(video_arg.getValue()).getNbFrames();
+  int nb_frames = std::min(nb_video_frames, meta_information.frames_size());
+  int chunk_size = std::max(1, chunk_arg.getValue());
+  int nb_chunks = (nb_frames + chunk_size - 1) / chunk_size;
+  int nb_threads = threads_arg.getValue();
+  if (nb_threads <= 0)
+  {
+    nb_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  nb_threads = std::min(nb_threads, std::max(1, nb_chunks));
+
+  // Each frame is written by a single worker: no synchronization required
+  std::vector<Pose3D> poses(nb_frames);
+  std::vector<uint8_t> refined(nb_frames, 0);
+  std::atomic<int> next_chunk(0);
+  std::atomic<int> nb_processed(0);
+  std::atomic<int> nb_failed(0);
+  std::atomic<int> nb_running(nb_threads);
+  std::vector<std::thread> workers;
+  for (int thread_id = 0; thread_id < nb_threads; thread_id++)
+  {
+    workers.push_back(std::thread([&]() {
+      // An exception escaping a thread terminates the program: errors are reported and the frames skipped
+      try
+      {
+        ReplayImageProvider provider(video_arg.getValue());
+        PoseTracker tracker(field);
+        tracker.setIntrinsic(meta_information.camera_parameters());
+        int chunk;
+        while ((chunk = next_chunk++) < nb_chunks)
+        {
+          int start = chunk * chunk_size;
+          int end = std::min(nb_frames, start + chunk_size);
+          int frame = start;
+          try
+          {
+            provider.setIndex(start);
+            tracker.setPose(meta_information.default_pose());
+            for (; frame < end; frame++)
+            {
+              cv::Mat img = provider.getNextImg();
+              refined[frame] = tracker.update(img, &poses[frame]);
+              nb_processed++;
+            }
+          }
+          catch (const std::exception& exc)
+          {
+            // Frame count of the container is only an estimate: reading may fail near the end of the video
+            std::cerr << std::endl
+                      << "Failed to process frames " << frame << " to " << end << ": " << exc.what() << std::endl;
+            nb_failed += end - frame;
+            nb_processed += end - frame;
+          }
+        }
+      }
+      catch (const std::exception& exc)
+      {
+        std::cerr << std::endl << "Worker failed: " << exc.what() << std::endl;
+      }
+      nb_running--;
+    }));
+  }
+
+  // Workers which failed to start leave their chunks to the others, stop waiting once all of them are over
+  while (nb_processed < nb_frames && nb_running > 0)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::cout << "\rProcessed frames: " << nb_processed << "/" << nb_frames << std::flush;
+  }
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+  std::cout << std::endl;
+
+  // Merging results in order
+  int nb_refined = 0;
+  for (int frame = 0; frame < nb_frames; frame++)
+  {
+    if (refined[frame])
+    {
+      meta_information.mutable_frames(frame)->mutable_pose()->CopyFrom(poses[frame]);
+      nb_refined++;
+    }
+  }
+  std::cout << "Refined poses: " << nb_refined << "/" << nb_frames << std::endl;
+  if (nb_failed > 0 || nb_processed < nb_frames)
+  {
+    std::cerr << "Frames not processed: " << (nb_frames - nb_processed + nb_failed) << std::endl;
+  }
+  writeToFile(output_arg.getValue(), meta_information);
+}
@@ -0,0 +1,95 @@
+/**
+ * Acquire video streams from a monitoring manager and publish them on frame
+ * buses in shared memory, allowing other processes to consume the images
+ * without opening the devices or the files.
+ *
+ * Each image provider named 'name' is published on bus '<prefix>_<name>'. Other
+ * processes can read it with a 'SharedMemoryImageProvider'. Each frame is
+ * published once, with the time_stamp of its acquisition.
+ */
+#include <hl_communication/utils.h>
+#include <hl_monitoring/monitoring_manager.h>
+#include <hl_monitoring/shared_memory_frame_bus.h>
+
+#include <tclap/CmdLine.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace hl_communication;
+using namespace hl_monitoring;
+
+int main(int argc, char** argv)
+{
+  TCLAP::CmdLine cmd("Publish the streams of a monitoring manager on shared memory frame buses", ' ', "0.9");
+
+  TCLAP::ValueArg<std::string> config_arg("c", "config", "The path to the json configuration file", true, "config.json",
+                                          "string", cmd);
+  TCLAP::ValueArg<std::string> prefix_arg("p", "prefix", "Prefix of the names of the buses", false, "/hl_monitoring",
+                                          "string", cmd);
+  TCLAP::ValueArg<int> slots_arg("s", "slots", "Number of frames stored in each bus", false, 8, "int", cmd);
+  TCLAP::SwitchArg unlink_arg("u", "unlink", "Replace the buses left by a previous publisher", cmd, false);
+
+  try
+  {
+    cmd.parse(argc, argv);
+  }
+  catch (const TCLAP::ArgException& e)
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  MonitoringManager manager;
+  manager.loadConfig(config_arg.getValue());
+
+  // Buses are created on first image, since image sizes are not known before
+  std::map<std::string, std::unique_ptr<SharedMemoryFramePublisher>> publishers;
+  std::map<std::string, CalibratedImage> images;
+  // time_stamp of the last frame published on each bus
+  std::map<std::string, uint64_t> last_time_stamps;
+
+  uint64_t now = 0;
+  uint64_t dt = 30 * 1000;  //[microseconds]
+  if (!manager.isLive())
+  {
+    now = manager.getStart();
+    manager.setOffset(getSteadyClockOffset());
+  }
+  while (manager.isGood())
+  {
+    manager.update();
+    if (manager.isLive())
+    {
+      now = getTimeStamp();
+    }
+    else
+    {
+      now += dt;
+      std::this_thread::sleep_for(std::chrono::microseconds(dt));
+    }
+    manager.getCalibratedImages(now, &images);
+    for (const auto& entry : images)
+    {
+      const cv::Mat& img = entry.second.getImg();
+      const ImageProvider& provider = manager.getImageProvider(entry.first);
+      uint64_t frame_time_stamp = provider.getFrameTimeStamp(now);
+      uint64_t& last_time_stamp = last_time_stamps[entry.first];
+      if (img.empty() || frame_time_stamp == 0 || frame_time_stamp == last_time_stamp)
+      {
+        continue;
+      }
+      last_time_stamp = frame_time_stamp;
+      std::unique_ptr<SharedMemoryFramePublisher>& publisher = publishers[entry.first];
+      if (!publisher)
+      {
+        std::string bus_name = prefix_arg.getValue() + "_" + entry.first;
+        publisher.reset(new SharedMemoryFramePublisher(bus_name, img.size(), img.type(), slots_arg.getValue(), 4096,
+                                                       unlink_arg.getValue()));
+        std::cout << "Publishing '" << entry.first << "' on bus '" << bus_name << "'" << std::endl;
+      }
+      publisher->setOffset(provider.getOffset());
+      publisher->publish(frame_time_stamp, entry.second);
+    }
+  }
+}
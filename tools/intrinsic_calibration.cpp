@@ -6,6 +6,7 @@
  */
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/rectifier.h>
 #include <hl_monitoring/replay_image_provider.h>
 #include <hl_monitoring/utils.h>
 
@@ -13,12 +14,233 @@
 #include <tclap/CmdLine.h>
 
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
 #include <iostream>
-#include <random>
+#include <mutex>
+#include <queue>
+#include <thread>
 
 using namespace hl_communication;
 using namespace hl_monitoring;
 
+/**
+ * Frame decoded from the video along with its position in the stream
+ */
+struct Frame
+{
+  int index;
+  cv::Mat img;
+};
+
+/**
+ * Chessboard found in a frame, corners are expressed at full resolution
+ */
+struct Detection
+{
+  int index;
+  std::vector<cv::Point2f> corners;
+  /**
+   * Variance of the Laplacian on the downscaled image
+   */
+  double sharpness;
+  /**
+   * Cells of the coverage grid containing at least one corner
+   */
+  std::vector<int> cells;
+  /**
+   * Bin describing the tilt of the board relative to the camera
+   */
+  int tilt_bin;
+};
+
+/**
+ * Size of the grid used to measure how well corners cover the image
+ */
+static const cv::Size coverage_grid(8, 6);
+
+/**
+ * Number of bins for the tilt of the board along each axis
+ */
+static const int nb_tilt_bins = 5;
+
+/**
+ * Fill the cells and the tilt bin of the detection. Tilt along each axis is
+ * estimated from the ratio between the lengths of opposite sides of the board
+ * which changes with perspective.
+ */
+void computeCoverage(const cv::Size& img_size, const cv::Size& pattern_size, Detection* detection)
+{
+  std::vector<bool> covered(coverage_grid.area(), false);
+  for (const cv::Point2f& corner : detection->corners)
+  {
+    int cell_x = std::min(coverage_grid.width - 1, std::max(0, (int)(corner.x * coverage_grid.width / img_size.width)));
+    int cell_y =
+        std::min(coverage_grid.height - 1, std::max(0, (int)(corner.y * coverage_grid.height / img_size.height)));
+    covered[cell_y * coverage_grid.width + cell_x] = true;
+  }
+  detection->cells.clear();
+  for (int cell = 0; cell < coverage_grid.area(); cell++)
+  {
+    if (covered[cell])
+    {
+      detection->cells.push_back(cell);
+    }
+  }
+  const std::vector<cv::Point2f>& c = detection->corners;
+  int w = pattern_size.width;
+  int h = pattern_size.height;
+  cv::Point2f top_left = c[0], top_right = c[w - 1], bottom_left = c[(h - 1) * w], bottom_right = c[h * w - 1];
+  double tilt_x = std::log(cv::norm(top_right - top_left) / cv::norm(bottom_right - bottom_left));
+  double tilt_y = std::log(cv::norm(bottom_left - top_left) / cv::norm(bottom_right - top_right));
+  // Bins are centered on a board parallel to the image plane
+  auto getBin = [](double tilt) {
+    double bin_width = 0.1;
+    int bin = (int)std::floor(tilt / bin_width + nb_tilt_bins / 2.0);
+    return std::min(nb_tilt_bins - 1, std::max(0, bin));
+  };
+  detection->tilt_bin = getBin(tilt_y) * nb_tilt_bins + getBin(tilt_x);
+}
+
+/**
+ * Counts how many selected detections cover each cell and each tilt bin
+ */
+class CoverageTracker
+{
+public:
+  CoverageTracker() : cell_counts(coverage_grid.area(), 0), tilt_counts(nb_tilt_bins * nb_tilt_bins, 0)
+  {
+  }
+
+  /**
+   * Value of adding the detection: cells and tilts rarely seen are worth more
+   */
+  double getGain(const Detection& detection) const
+  {
+    double gain = 0;
+    for (int cell : detection.cells)
+    {
+      gain += 1.0 / (1 + cell_counts[cell]);
+    }
+    // A new tilt is worth as much as a few new cells
+    double tilt_weight = 4;
+    gain += tilt_weight / (1 + tilt_counts[detection.tilt_bin]);
+    return gain;
+  }
+
+  /**
+   * Add the detection, returns true if it covers a cell or a tilt bin never seen before
+   */
+  bool add(const Detection& detection)
+  {
+    bool is_new = tilt_counts[detection.tilt_bin] == 0;
+    tilt_counts[detection.tilt_bin]++;
+    for (int cell : detection.cells)
+    {
+      is_new = is_new || cell_counts[cell] == 0;
+      cell_counts[cell]++;
+    }
+    return is_new;
+  }
+
+private:
+  std::vector<int> cell_counts;
+  std::vector<int> tilt_counts;
+};
+
+/**
+ * Queue of frames with a bounded capacity to limit the memory used when
+ * decoding is faster than detection
+ */
+class FrameQueue
+{
+public:
+  FrameQueue(size_t capacity_) : capacity(capacity_), closed(false)
+  {
+  }
+
+  /**
+   * Wait until there is room in the queue and push the frame
+   */
+  void push(Frame frame)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this]() { return frames.size() < capacity; });
+    frames.push(std::move(frame));
+    not_empty.notify_one();
+  }
+
+  /**
+   * Wait for a frame, returns false if the queue is closed and empty
+   */
+  bool pop(Frame* frame)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_empty.wait(lock, [this]() { return !frames.empty() || closed; });
+    if (frames.empty())
+    {
+      return false;
+    }
+    *frame = std::move(frames.front());
+    frames.pop();
+    not_full.notify_one();
+    return true;
+  }
+
+  /**
+   * Signal that no other frames will be pushed
+   */
+  void close()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+    not_empty.notify_all();
+  }
+
+private:
+  size_t capacity;
+  bool closed;
+  std::queue<Frame> frames;
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+};
+
+/**
+ * Look for the chessboard on a downscaled version of the image and refine the
+ * corners at full resolution. Returns true on success.
+ */
+bool detectChessboard(const cv::Mat& img, const cv::Size& pattern_size, int detection_width,
+                      std::vector<cv::Point2f>* corners, double* sharpness)
+{
+  cv::Mat gray;
+  cv::cvtColor(img, gray, CV_BGR2GRAY);
+  double scale = std::min(1.0, detection_width / (double)gray.cols);
+  cv::Mat small_gray = gray;
+  if (scale < 1.0)
+  {
+    cv::resize(gray, small_gray, cv::Size(), scale, scale, cv::INTER_AREA);
+  }
+  int flags = cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_FAST_CHECK;
+  if (!cv::findChessboardCorners(small_gray, pattern_size, *corners, flags))
+  {
+    return false;
+  }
+  // Scoring sharpness is cheap on the downscaled image
+  cv::Mat laplacian;
+  cv::Laplacian(small_gray, laplacian, CV_16S);
+  cv::Scalar mean, stddev;
+  cv::meanStdDev(laplacian, mean, stddev);
+  *sharpness = stddev[0] * stddev[0];
+  for (cv::Point2f& corner : *corners)
+  {
+    corner *= 1.0 / scale;
+  }
+  cv::TermCriteria criteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.01);
+  cv::cornerSubPix(gray, *corners, cv::Size(11, 11), cv::Size(-1, -1), criteria);
+  return true;
+}
+
 // This calibration method is highly inspired from:
 // https://docs.opencv.org/3.2.0/dc/dbb/tutorial_py_calibration.html
 int main(int argc, char** argv)
@@ -34,6 +256,18 @@ int main(int argc, char** argv)
                                        "float");
   TCLAP::ValueArg<float> nb_images_arg("n", "nb_images", "Maximal number of images used for training", false, 20,
                                        "int");
+  TCLAP::ValueArg<int> threads_arg("j", "threads", "Number of threads used for detection (0: number of cores)", false,
+                                   0, "int", cmd);
+  TCLAP::ValueArg<int> width_arg("w", "detection_width", "Width of the images used for detection", false, 640, "int",
+                                 cmd);
+  TCLAP::ValueArg<int> patience_arg("p", "patience",
+                                    "Stop decoding after this number of detections without coverage improvement "
+                                    "(0: decode the whole video)",
+                                    false, 200, "int", cmd);
+  TCLAP::ValueArg<double> tolerance_arg("t", "tolerance",
+                                        "Relative variation of the reprojection error under which adding images to "
+                                        "the calibration stops",
+                                        false, 0.02, "double", cmd);
   TCLAP::SwitchArg show_switch("s", "show", "Show images used for calibration and after calibration", cmd, false);
 
   cmd.add(video_arg);
@@ -41,8 +275,6 @@ int main(int argc, char** argv)
   cmd.add(nb_images_arg);
   cmd.add(frequency_arg);
 
-  double sleep_time = 1000 / frequency_arg.getValue();
-
   try
   {
     cmd.parse(argc, argv);
@@ -52,118 +284,211 @@ int main(int argc, char** argv)
     std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
   }
 
+  double sleep_time = 1000 / frequency_arg.getValue();
+
   ReplayImageProvider image_provider(video_arg.getValue());
 
   std::vector<std::vector<cv::Point3f>> objPoints;
   std::vector<std::vector<cv::Point2f>> imgPoints;
   cv::Size img_size;
+  cv::Size patternSize(9, 6);
 
-  int successCount = 0;
-  int imageCount = 0;
-  while (!image_provider.isStreamFinished())
+  int nb_threads = threads_arg.getValue();
+  if (nb_threads <= 0)
   {
-    cv::Mat img = image_provider.getNextImg();
-
-    img_size = img.size();
-
-    cv::Mat gray;
-    cv::cvtColor(img, gray, CV_BGR2GRAY);
+    nb_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
 
-    std::vector<cv::Point2f> corners;
-    cv::Size patternSize(9, 6);
-    bool success = cv::findChessboardCorners(gray, patternSize, corners);
+  // The main thread decodes the video while workers look for chessboards
+  FrameQueue queue(2 * nb_threads);
+  std::mutex detections_mutex;
+  std::vector<Detection> detections;
+  // Last image with a detected chessboard, only used for display
+  cv::Mat last_detection_img;
+  std::vector<std::thread> workers;
+  for (int thread_id = 0; thread_id < nb_threads; thread_id++)
+  {
+    workers.push_back(std::thread([&]() {
+      Frame frame;
+      while (queue.pop(&frame))
+      {
+        Detection detection;
+        detection.index = frame.index;
+        if (detectChessboard(frame.img, patternSize, width_arg.getValue(), &detection.corners,
+                             &detection.sharpness))
+        {
+          computeCoverage(frame.img.size(), patternSize, &detection);
+          std::unique_lock<std::mutex> lock(detections_mutex);
+          if (show_switch.getValue())
+          {
+            cv::drawChessboardCorners(frame.img, patternSize, detection.corners, true);
+            last_detection_img = frame.img;
+          }
+          detections.push_back(std::move(detection));
+        }
+      }
+    }));
+  }
 
-    if (!success)
+  // Coverage of all the detections, used to stop decoding once it saturates
+  CoverageTracker decoding_coverage;
+  size_t nb_tracked_detections = 0;
+  int detections_without_improvement = 0;
+  int patience = patience_arg.getValue();
+  int imageCount = 0;
+  int64_t last_display = 0;
+  while (!image_provider.isStreamFinished() && (patience <= 0 || detections_without_improvement < patience))
+  {
+    Frame frame;
+    frame.index = imageCount;
+    // Provider reuses its buffer between calls
+    frame.img = image_provider.getNextImg().clone();
+    img_size = frame.img.size();
+    queue.push(std::move(frame));
+    imageCount++;
     {
-      if (show_switch.getValue())
+      std::unique_lock<std::mutex> lock(detections_mutex);
+      for (; nb_tracked_detections < detections.size(); nb_tracked_detections++)
       {
-        cv::imshow("test", img);
-        cv::waitKey(sleep_time);
+        bool improved = decoding_coverage.add(detections[nb_tracked_detections]);
+        detections_without_improvement = improved ? 0 : detections_without_improvement + 1;
       }
     }
-    else
+    int64_t now = getTimeStamp();
+    if (show_switch.getValue() && now - last_display > sleep_time * 1000)
     {
-      successCount++;
-      if (show_switch.getValue())
+      cv::Mat display_img;
       {
-        cv::drawChessboardCorners(img, patternSize, corners, success);
-        cv::imshow("test", img);
-        cv::waitKey(sleep_time);
+        std::unique_lock<std::mutex> lock(detections_mutex);
+        display_img = last_detection_img;
       }
-
-      std::vector<cv::Point3f> currentObjPoints;
-      double markerSize = 0.05;
-      for (int row = 0; row < patternSize.height; row++)
+      if (!display_img.empty())
       {
-        for (int col = 0; col < patternSize.width; col++)
-        {
-          currentObjPoints.push_back(cv::Point3f(row * markerSize, col * markerSize, 0));
-        }
+        cv::imshow("test", display_img);
+        cv::waitKey(1);
       }
-      objPoints.push_back(currentObjPoints);
-      imgPoints.push_back(corners);
+      last_display = now;
     }
-    imageCount++;
   }
+  queue.close();
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+  int successCount = detections.size();
 
-  std::cout << "Success: " << successCount << "/" << imageCount << std::endl;
+  // Workers complete detections out of order
+  std::sort(detections.begin(), detections.end(),
+            [](const Detection& d1, const Detection& d2) { return d1.index < d2.index; });
+  std::vector<cv::Point3f> currentObjPoints;
+  double markerSize = 0.05;
+  for (int row = 0; row < patternSize.height; row++)
+  {
+    for (int col = 0; col < patternSize.width; col++)
+    {
+      currentObjPoints.push_back(cv::Point3f(row * markerSize, col * markerSize, 0));
+    }
+  }
 
-  int nb_images = nb_images_arg.getValue();
+  std::cout << "Success: " << successCount << "/" << imageCount << std::endl;
+  if (detections.empty())
+  {
+    throw std::runtime_error(HL_DEBUG + "no chessboard found in the video");
+  }
 
-  if ((int)objPoints.size() > nb_images)
+  // Blurred images are discarded, the threshold is relative to the median
+  // sharpness since absolute values depend on the scene
+  std::vector<double> sharpnesses;
+  for (const Detection& detection : detections)
   {
-    // Associating data
-    typedef std::pair<std::vector<cv::Point3f>, std::vector<cv::Point2f>> LearningEntry;
-    std::vector<LearningEntry> learning_data;
-    for (size_t idx = 0; idx < objPoints.size(); idx++)
+    sharpnesses.push_back(detection.sharpness);
+  }
+  std::nth_element(sharpnesses.begin(), sharpnesses.begin() + sharpnesses.size() / 2, sharpnesses.end());
+  double min_sharpness = 0.5 * sharpnesses[sharpnesses.size() / 2];
+  double max_sharpness = *std::max_element(sharpnesses.begin(), sharpnesses.end());
+  std::vector<const Detection*> candidates;
+  for (const Detection& detection : detections)
+  {
+    if (detection.sharpness >= min_sharpness)
     {
-      LearningEntry entry(objPoints[idx], imgPoints[idx]);
-      learning_data.push_back(entry);
+      candidates.push_back(&detection);
     }
-    // Shuffling data
-    std::random_device rd;
-    std::mt19937 generator(rd());
-    std::shuffle(learning_data.begin(), learning_data.end(), generator);
-    // Picking up n first elements
-    objPoints.clear();
-    imgPoints.clear();
-    for (int idx = 0; idx < nb_images; idx++)
+  }
+
+  // Greedy selection: images are sorted by decreasing contribution to coverage
+  int nb_images = nb_images_arg.getValue();
+  CoverageTracker selection_coverage;
+  while ((int)imgPoints.size() < nb_images && !candidates.empty())
+  {
+    size_t best_idx = 0;
+    double best_score = -1;
+    for (size_t idx = 0; idx < candidates.size(); idx++)
     {
-      objPoints.push_back(learning_data[idx].first);
-      imgPoints.push_back(learning_data[idx].second);
+      double sharpness_factor = 0.5 + 0.5 * candidates[idx]->sharpness / max_sharpness;
+      double score = selection_coverage.getGain(*candidates[idx]) * sharpness_factor;
+      if (score > best_score)
+      {
+        best_score = score;
+        best_idx = idx;
+      }
     }
+    selection_coverage.add(*candidates[best_idx]);
+    objPoints.push_back(currentObjPoints);
+    imgPoints.push_back(candidates[best_idx]->corners);
+    candidates.erase(candidates.begin() + best_idx);
   }
+  std::cout << "Selected " << imgPoints.size() << " images" << std::endl;
 
-  // Calibration
+  // Incremental calibration: most informative images come first, images are
+  // added until the reprojection error stabilizes
   cv::Mat camera_matrix;
   cv::Mat distortion_coeffs;
   std::vector<cv::Mat> rvecs, tvecs;
-
-  double error = cv::calibrateCamera(objPoints, imgPoints, img_size, camera_matrix, distortion_coeffs, rvecs, tvecs);
+  size_t min_images = 5;
+  size_t images_step = 5;
+  double error = -1;
+  size_t nb_used = std::min(min_images, imgPoints.size());
+  while (true)
+  {
+    std::vector<std::vector<cv::Point3f>> used_obj_points(objPoints.begin(), objPoints.begin() + nb_used);
+    std::vector<std::vector<cv::Point2f>> used_img_points(imgPoints.begin(), imgPoints.begin() + nb_used);
+    int flags = camera_matrix.empty() ? 0 : cv::CALIB_USE_INTRINSIC_GUESS;
+    double previous_error = error;
+    error = cv::calibrateCamera(used_obj_points, used_img_points, img_size, camera_matrix, distortion_coeffs, rvecs,
+                                tvecs, flags);
+    std::cout << "Error with " << nb_used << " images: " << error << std::endl;
+    double variation = std::fabs(error - previous_error);
+    bool converged = previous_error > 0 && variation < tolerance_arg.getValue() * previous_error;
+    if (converged || nb_used == imgPoints.size())
+    {
+      break;
+    }
+    nb_used = std::min(nb_used + images_step, imgPoints.size());
+  }
 
   std::cout << "Error: " << error << std::endl;
   std::cout << "Camera Matrix: " << camera_matrix << std::endl;
   std::cout << "Distortion Coeffs: " << distortion_coeffs << std::endl;
 
+  IntrinsicParameters result;
+  cvToIntrinsic(camera_matrix, distortion_coeffs, img_size, &result);
+
   if (show_switch.getValue())
   {
-    cv::Mat optimalMatrix;
-    optimalMatrix = cv::getOptimalNewCameraMatrix(camera_matrix, distortion_coeffs, img_size, 0.0);
+    Rectifier rectifier;
+    rectifier.setIntrinsic(result);
     cv::Mat undistorded;
     image_provider.restartStream();
     while (!image_provider.isStreamFinished())
     {
       cv::Mat img = image_provider.getNextImg();
-      // Undistort
-      cv::undistort(img, undistorded, camera_matrix, distortion_coeffs);  //, optimalMatrix);
+      rectifier.rectify(img, &undistorded);
       cv::imshow("img", img);
       cv::imshow("undistorded", undistorded);
       cv::waitKey(sleep_time);
     }
   }
 
-  IntrinsicParameters result;
-  cvToIntrinsic(camera_matrix, distortion_coeffs, img_size, &result);
   std::ofstream out(output_arg.getValue());
   if (!out.good())
   {
@@ -1,9 +1,22 @@
+/**
+ * Build or edit the meta information of a video without loading all the
+ * frame entries in memory:
+ * - Header content (intrinsic parameters, default pose) can be merged from other files
+ * - Multiple meta information can be concatenated, header is taken from the first one
+ *   and frames of the other segments are shifted to the time_offset of the first one
+ * - Frame time_stamps can be extracted from the video container
+ * - Frames can be trimmed to a range of time_stamps and shifted by an offset
+ */
 #include <hl_communication/utils.h>
 #include <hl_monitoring/camera.pb.h>
-#include <hl_monitoring/replay_image_provider.h>
+#include <hl_monitoring/meta_information_reader.h>
+#include <hl_monitoring/meta_information_writer.h>
+#include <hl_monitoring/video_time_stamps.h>
 
 #include <tclap/CmdLine.h>
 
+#include <limits>
+
 using namespace hl_communication;
 using namespace hl_monitoring;
 
@@ -12,21 +25,29 @@ int main(int argc, char** argv)
   TCLAP::CmdLine cmd("Combine multiple type of files to create meta information for a video", ' ', "0.9");
 
   TCLAP::ValueArg<std::string> video_arg("v", "video",
-                                         "Path to a video, if specified, use the video as a "
-                                         "source to create the time_stamps for each frame",
+                                         "Path to a video, if specified, use the presentation time_stamps of the "
+                                         "video to create the frame entries",
                                          false, "", "path", cmd);
   TCLAP::ValueArg<std::string> intrinsic_arg("i", "intrinsic",
                                              "Path to the file describing intrinsic parameters "
                                              "of the camera.",
                                              false, "", "path", cmd);
-  TCLAP::ValueArg<std::string> meta_arg("m", "meta-information", "Path to a file containing initial meta-information",
-                                        false, "", "path", cmd);
+  TCLAP::MultiArg<std::string> meta_arg("m", "meta-information",
+                                        "Path to a file containing initial meta-information, if used multiple "
+                                        "times, frame entries are concatenated",
+                                        false, "path", cmd);
   TCLAP::ValueArg<std::string> pose_arg("p", "pose", "Path to the file describing the pose of the camera", false, "",
                                         "path", cmd);
   TCLAP::ValueArg<std::string> output_arg("o", "output", "The output path for the meta_information", true,
                                           "meta_information.bin", "path", cmd);
-  TCLAP::ValueArg<double> dt_arg("t", "step_time", "The interval between two frames when a video is provided", false,
-                                 0.03, "seconds", cmd);
+  TCLAP::ValueArg<uint64_t> video_start_arg("", "video_start",
+                                            "time_stamp of the first frame of the video [us]", false, 0, "us", cmd);
+  TCLAP::ValueArg<uint64_t> start_arg("s", "start", "Frames before this time_stamp are removed [us]", false, 0, "us",
+                                      cmd);
+  TCLAP::ValueArg<uint64_t> end_arg("e", "end", "Frames after this time_stamp are removed [us]", false,
+                                    std::numeric_limits<uint64_t>::max(), "us", cmd);
+  TCLAP::ValueArg<int64_t> offset_arg("d", "offset", "Offset added to the time_stamps of the frames kept [us]", false,
+                                      0, "us", cmd);
   TCLAP::SwitchArg force_switch("f", "force", "Allows to overwrite existing data in meta-information", cmd, false);
   try
   {
@@ -38,49 +59,106 @@ int main(int argc, char** argv)
     exit(EXIT_FAILURE);
   }
 
-  VideoMetaInformation information;
+  VideoMetaInformation header;
 
   bool force = force_switch.getValue();
 
-  if (meta_arg.getValue() != "")
+  // Only headers are parsed, frames are streamed from the readers to the output
+  std::vector<std::unique_ptr<MetaInformationReader>> readers;
+  int nb_input_frames = 0;
+  for (const std::string& path : meta_arg.getValue())
+  {
+    if (path == output_arg.getValue())
+    {
+      throw std::runtime_error(HL_DEBUG + "output file '" + path + "' is also used as input");
+    }
+    readers.push_back(std::unique_ptr<MetaInformationReader>(new MetaInformationReader(path)));
+    nb_input_frames += readers.back()->getNbFrames();
+  }
+  if (readers.size() > 0)
   {
-    readFromFile(meta_arg.getValue(), &information);
+    header.CopyFrom(readers.front()->getHeader());
   }
   if (pose_arg.getValue() != "")
   {
-    if (!force && information.has_default_pose())
+    if (!force && header.has_default_pose())
     {
       throw std::runtime_error(HL_DEBUG + "video meta information already contains default pose."
                                           " use -f to overwrite");
     }
-    readFromFile(pose_arg.getValue(), information.mutable_default_pose());
+    readFromFile(pose_arg.getValue(), header.mutable_default_pose());
   }
   if (intrinsic_arg.getValue() != "")
   {
-    if (!force && information.has_camera_parameters())
+    if (!force && header.has_camera_parameters())
     {
       throw std::runtime_error(HL_DEBUG + "video meta information already contains camera_parameters."
                                           " use -f to overwrite");
     }
-    readFromFile(intrinsic_arg.getValue(), information.mutable_camera_parameters());
+    readFromFile(intrinsic_arg.getValue(), header.mutable_camera_parameters());
   }
+  if (video_arg.getValue() != "" && !force && nb_input_frames > 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "video meta information already contains frame entries."
+                                        " use -f to overwrite");
+  }
+
+  MetaInformationWriter writer(output_arg.getValue());
+  writer.writeHeader(header);
+
+  uint64_t start = start_arg.getValue();
+  uint64_t end = end_arg.getValue();
+  int64_t offset = offset_arg.getValue();
+  // Difference between the time_offset of the current segment and the time_offset of the output
+  int64_t segment_shift = 0;
+  auto writeFrame = [&](FrameEntry* frame) {
+    uint64_t time_stamp = frame->time_stamp();
+    if (segment_shift < 0 && time_stamp < (uint64_t)(-segment_shift))
+    {
+      throw std::runtime_error(HL_DEBUG + "negative time_stamp after applying time_offset of segment to " +
+                               std::to_string(time_stamp));
+    }
+    time_stamp += segment_shift;
+    if (time_stamp < start || time_stamp > end)
+    {
+      return;
+    }
+    if (offset < 0 && time_stamp < (uint64_t)(-offset))
+    {
+      throw std::runtime_error(HL_DEBUG + "negative time_stamp after applying offset to " + std::to_string(time_stamp));
+    }
+    frame->set_time_stamp(time_stamp + offset);
+    writer.writeFrame(*frame);
+  };
+
+  FrameEntry frame;
   if (video_arg.getValue() != "")
   {
-    if (!force && information.frames_size() > 0)
+    for (uint64_t pts : readVideoTimeStamps(video_arg.getValue()))
     {
-      throw std::runtime_error(HL_DEBUG + "video meta information already contains frame entries."
-                                          " use -f to overwrite");
+      frame.Clear();
+      frame.set_time_stamp(video_start_arg.getValue() + pts);
+      writeFrame(&frame);
     }
-    ReplayImageProvider video(video_arg.getValue());
-    double dt = dt_arg.getValue();
-    int nb_frames = video.getNbFrames();
-    information.clear_frames();
-    for (int i = 0; i < nb_frames; i++)
+  }
+  else
+  {
+    for (size_t idx = 0; idx < readers.size(); idx++)
     {
-      uint64 time_stamp = dt * i * 1000 * 1000;
-      information.add_frames()->set_time_stamp(time_stamp);
+      const std::unique_ptr<MetaInformationReader>& reader = readers[idx];
+      const VideoMetaInformation& segment_header = reader->getHeader();
+      if (segment_header.has_time_offset() != header.has_time_offset())
+      {
+        throw std::runtime_error(HL_DEBUG + "time_offset is specified only in some of the inputs: '" +
+                                 meta_arg.getValue()[idx] + "' disagrees with '" + meta_arg.getValue()[0] + "'");
+      }
+      segment_shift = segment_header.time_offset() - header.time_offset();
+      while (reader->readNextFrame(&frame))
+      {
+        writeFrame(&frame);
+      }
     }
   }
-
-  writeToFile(output_arg.getValue(), information);
+  writer.close();
+  std::cout << "Frames written: " << writer.getNbFrames() << std::endl;
 }
@@ -0,0 +1,114 @@
+/**
+ * Compare the projection kernel of CameraModel with cv::projectPoints for all
+ * the supported distortion models.
+ *
+ * Points are drawn uniformly on the ground of a synthetic field observed by a
+ * camera placed on its side, results are printed as the time per point along
+ * with the maximal difference between both methods.
+ */
+#include <hl_communication/utils.h>
+#include <hl_monitoring/camera_model.h>
+
+#include <opencv2/calib3d.hpp>
+#include <tclap/CmdLine.h>
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace hl_communication;
+using namespace hl_monitoring;
+
+CameraMetaInformation buildCamera(int distortion_size)
+{
+  // Small coefficients with all terms active, similar to wide angle lenses
+  std::vector<double> coefficients = { -0.25, 0.08, 0.001, -0.0005, -0.01, 0.02, -0.005, 0.001 };
+  CameraMetaInformation camera_meta;
+  IntrinsicParameters* intrinsic = camera_meta.mutable_camera_parameters();
+  intrinsic->set_focal_x(700);
+  intrinsic->set_focal_y(700);
+  intrinsic->set_center_x(640);
+  intrinsic->set_center_y(360);
+  intrinsic->set_img_width(1280);
+  intrinsic->set_img_height(720);
+  for (int idx = 0; idx < distortion_size; idx++)
+  {
+    intrinsic->add_distortion(coefficients[idx]);
+  }
+  // Camera about 1m above the ground and 6m away from the center, looking at the field
+  cv::Mat rvec = (cv::Mat_<double>(3, 1) << -2.0, 0, 0);
+  cv::Mat tvec = (cv::Mat_<double>(3, 1) << 0, 1.5, 6.0);
+  Pose3D* pose = camera_meta.mutable_pose();
+  for (int idx = 0; idx < 3; idx++)
+  {
+    pose->add_rotation(rvec.at<double>(idx, 0));
+    pose->add_translation(tvec.at<double>(idx, 0));
+  }
+  return camera_meta;
+}
+
+int main(int argc, char** argv)
+{
+  TCLAP::CmdLine cmd("Benchmark of the projection of points from field to image", ' ', "0.9");
+  TCLAP::ValueArg<int> points_arg("p", "points", "Number of points projected per iteration", false, 10000, "int", cmd);
+  TCLAP::ValueArg<int> iterations_arg("i", "iterations", "Number of iterations per method", false, 100, "int", cmd);
+
+  try
+  {
+    cmd.parse(argc, argv);
+  }
+  catch (const TCLAP::ArgException& e)
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  int nb_points = points_arg.getValue();
+  int nb_iterations = iterations_arg.getValue();
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<float> x_distrib(-4.5, 4.5);
+  std::uniform_real_distribution<float> y_distrib(-3, 3);
+  std::vector<cv::Point3f> pos_in_field;
+  for (int idx = 0; idx < nb_points; idx++)
+  {
+    pos_in_field.push_back(cv::Point3f(x_distrib(engine), y_distrib(engine), 0));
+  }
+
+  std::cout << std::setw(12) << "distortion" << std::setw(16) << "opencv [ns/pt]" << std::setw(16) << "kernel [ns/pt]"
+            << std::setw(10) << "speedup" << std::setw(16) << "max diff [px]" << std::endl;
+  for (int distortion_size : { 0, 2, 5, 8 })
+  {
+    CameraModel model(buildCamera(distortion_size));
+    std::vector<cv::Point2f> opencv_result(nb_points), kernel_result(nb_points);
+
+    cv::Mat object_points(nb_points, 1, CV_32FC3, pos_in_field.data());
+    cv::Mat img_points(nb_points, 1, CV_32FC2, opencv_result.data());
+    int64_t opencv_start = getTimeStamp();
+    for (int iter = 0; iter < nb_iterations; iter++)
+    {
+      cv::projectPoints(object_points, model.getRVec(), model.getTVec(), model.getCameraMatrix(),
+                        model.getDistortionCoefficients(), img_points);
+    }
+    int64_t opencv_end = getTimeStamp();
+    for (int iter = 0; iter < nb_iterations; iter++)
+    {
+      model.fieldToImg(pos_in_field.data(), nb_points, kernel_result.data());
+    }
+    int64_t kernel_end = getTimeStamp();
+
+    double max_diff = 0;
+    for (int idx = 0; idx < nb_points; idx++)
+    {
+      if (model.isInFront(pos_in_field[idx]))
+      {
+        max_diff = std::max(max_diff, (double)cv::norm(opencv_result[idx] - kernel_result[idx]));
+      }
+    }
+    double total_points = (double)nb_points * nb_iterations;
+    double opencv_ns = (opencv_end - opencv_start) * 1000.0 / total_points;
+    double kernel_ns = (kernel_end - opencv_end) * 1000.0 / total_points;
+    std::cout << std::setw(12) << distortion_size << std::setw(16) << opencv_ns << std::setw(16) << kernel_ns
+              << std::setw(10) << (opencv_ns / kernel_ns) << std::setw(16) << max_diff << std::endl;
+  }
+}
@@ -3,12 +3,21 @@
  * parameters of the camera. It uses manual input to estimate the pose of the
  * camera and then draw the field inside the image for the rest of the video.
  *
+ * Once the pose has been estimated manually, the pose can be tracked
+ * automatically while playing the video, poses of all the frames are then
+ * written in a new meta_information file.
+ *
  * User interface notes:
- * - TODO
+ * - q: quit
+ * - i: ignore current point
+ * - n: next frame
+ * - c: cancel last point
+ * - t: start/stop automatic tracking of the pose
  */
 
 #include <hl_communication/utils.h>
 #include <hl_monitoring/field.h>
+#include <hl_monitoring/pose_tracker.h>
 #include <hl_monitoring/replay_image_provider.h>
 #include <hl_monitoring/utils.h>
 
@@ -26,10 +35,19 @@ class StaticCalibrationTool
 public:
   StaticCalibrationTool(std::unique_ptr<ImageProvider> provider_, std::unique_ptr<Field> field_,
                         const IntrinsicParameters& camera_parameters)
-    : provider(std::move(provider_)), field(std::move(field_)), point_index(0), is_good(true)
+    : provider(std::move(provider_))
+    , field(std::move(field_))
+    , tracker(*field)
+    , point_index(0)
+    , frame_index(0)
+    , is_tracking(false)
+    , is_refined(false)
+    , is_good(true)
   {
     calib_img = provider->getNextImg();
     intrinsicToCV(camera_parameters, &camera_matrix, &distortion_coefficients, &img_size);
+    tracker.setIntrinsic(camera_parameters);
+    tracked_meta.CopyFrom(provider->getMetaInformation());
 
     for (const auto& entry : field->getPointsOfInterest())
     {
@@ -96,9 +114,35 @@ public:
     return oss.str();
   }
 
+  /**
+   * Read the next frame and refine the pose from the previous one
+   */
+  void trackPose()
+  {
+    if (provider->isStreamFinished())
+    {
+      is_tracking = false;
+      return;
+    }
+    calib_img = provider->getNextImg();
+    frame_index++;
+    Pose3D pose;
+    is_refined = tracker.update(calib_img, &pose);
+    pose3DToCV(pose, &rvec, &tvec);
+    // When tracking is lost, the pose of the frame is left untouched so that it is interpolated from its neighbors
+    if (is_refined && frame_index < tracked_meta.frames_size())
+    {
+      tracked_meta.mutable_frames(frame_index)->mutable_pose()->CopyFrom(pose);
+    }
+  }
+
   // Main loop
   void update()
   {
+    if (is_tracking)
+    {
+      trackPose();
+    }
     cv::Mat display_img = calib_img.clone();
     for (const auto& entry : points_in_img)
     {
@@ -109,7 +153,15 @@ public:
       field->tagLines(camera_matrix, distortion_coefficients, rvec, tvec, &display_img, cv::Scalar(0, 0, 0), 2);
     }
 
-    cv::putText(display_img, getTagRequest(), cv::Point(0, 30), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 0, 0), 2);
+    std::string status = getTagRequest();
+    if (is_tracking)
+    {
+      std::ostringstream oss;
+      oss << (is_refined ? "Tracking: " : "Tracking lost: ") << tracker.getNbMatches()
+          << " matches, error: " << tracker.getError() << " px";
+      status = oss.str();
+    }
+    cv::putText(display_img, status, cv::Point(0, 30), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0, 0, 0), 2);
 
     cv::imshow("display", display_img);
     char key = cv::waitKey(30);
@@ -124,6 +176,16 @@ public:
         break;
       case 'n':  // Next
         calib_img = provider->getNextImg();
+        frame_index++;
+        break;
+      case 't':  // Toggle tracking
+        if (points_in_img.size() >= 4)
+        {
+          Pose3D pose;
+          cvToPose3D(rvec, tvec, &pose);
+          tracker.setPose(pose);
+          is_tracking = !is_tracking;
+        }
         break;
       case 'c':  // Cancel
         if (point_index > 0)
@@ -148,10 +210,25 @@ public:
     pose.SerializeToOstream(&out);
   }
 
+  /**
+   * Write the meta information of the video with the poses estimated by tracking
+   */
+  void saveTrackedPoses(const std::string& path)
+  {
+    hl_communication::writeToFile(path, tracked_meta);
+  }
+
 private:
   std::unique_ptr<ImageProvider> provider;
   std::unique_ptr<Field> field;
 
+  PoseTracker tracker;
+
+  /**
+   * Meta information of the video, completed with the poses of tracked frames
+   */
+  VideoMetaInformation tracked_meta;
+
   cv::Mat calib_img;
 
   cv::Mat camera_matrix;
@@ -179,6 +256,18 @@ private:
    */
   int point_index;
 
+  /**
+   * Index of the frame currently displayed
+   */
+  int frame_index;
+
+  bool is_tracking;
+
+  /**
+   * Was the pose of the frame currently displayed refined by the tracker
+   */
+  bool is_refined;
+
   bool is_good;
 };
 
@@ -195,6 +284,11 @@ int main(int argc, char** argv)
                                              true, "intrinsic.bin", "string");
   TCLAP::ValueArg<std::string> field_arg("f", "field", "The path to the field file containing the dimensions", true,
                                          "field.json", "string");
+  TCLAP::ValueArg<std::string> meta_arg("m", "meta", "The path to the meta information of the video", false, "",
+                                        "string", cmd);
+  TCLAP::ValueArg<std::string> tracked_arg("t", "tracked_output",
+                                           "The output path for the meta information with tracked poses", false, "",
+                                           "string", cmd);
   cmd.add(video_arg);
   cmd.add(output_arg);
   cmd.add(intrinsic_arg);
@@ -209,7 +303,19 @@ int main(int argc, char** argv)
     std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
   }
 
-  std::unique_ptr<ImageProvider> provider(new ReplayImageProvider(video_arg.getValue()));
+  std::unique_ptr<ImageProvider> provider;
+  if (meta_arg.getValue() != "")
+  {
+    provider.reset(new ReplayImageProvider(video_arg.getValue(), meta_arg.getValue()));
+  }
+  else if (tracked_arg.getValue() != "")
+  {
+    throw std::runtime_error(HL_DEBUG + " meta information is required to write tracked poses");
+  }
+  else
+  {
+    provider.reset(new ReplayImageProvider(video_arg.getValue()));
+  }
 
   IntrinsicParameters intrinsic;
   std::ifstream in(intrinsic_arg.getValue());
@@ -229,4 +335,8 @@ int main(int argc, char** argv)
     calib_tool.update();
   }
   calib_tool.savePose(output_arg.getValue());
+  if (tracked_arg.getValue() != "")
+  {
+    calib_tool.saveTrackedPoses(tracked_arg.getValue());
+  }
 }
@@ -0,0 +1,297 @@
+/**
+ * Render a synthetic recording of a match with a known ground truth.
+ *
+ * The following files are produced, all based on the provided prefix:
+ * - <prefix>.avi: the video, field lines and robots are drawn with the true
+ *   projection of the camera
+ * - <prefix>.bin: meta information of the video with the intrinsic parameters,
+ *   the time_stamps and the poses of the camera (default pose for a static
+ *   camera, a pose per frame for a moving camera)
+ * - <prefix>_messages.bin: GameController and robot messages with the true
+ *   positions of the robots at the time_stamp of each message
+ *
+ * The scene is simulated at the nominal period of the video, the jitter only
+ * affects the time_stamps written for the frames.
+ *
+ * All random elements are drawn from the provided seed: the same command always
+ * produces the same recording.
+ */
+#include <hl_communication/utils.h>
+#include <hl_communication/wrapper.pb.h>
+#include <hl_monitoring/field.h>
+#include <hl_monitoring/meta_information_writer.h>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <tclap/CmdLine.h>
+
+#include <cmath>
+#include <random>
+
+using namespace hl_communication;
+using namespace hl_monitoring;
+
+/**
+ * Pose of a camera located at camera_pos and looking at target, the x-axis of
+ * the image stays horizontal
+ */
+Pose3D lookAt(const cv::Point3d& camera_pos, const cv::Point3d& target)
+{
+  cv::Vec3d z_axis = cv::normalize(cv::Vec3d(target - camera_pos));
+  cv::Vec3d x_axis = cv::normalize(z_axis.cross(cv::Vec3d(0, 0, 1)));
+  cv::Vec3d y_axis = z_axis.cross(x_axis);
+  cv::Matx33d rotation(x_axis[0], x_axis[1], x_axis[2], y_axis[0], y_axis[1], y_axis[2], z_axis[0], z_axis[1],
+                       z_axis[2]);
+  cv::Vec3d translation = -(rotation * cv::Vec3d(camera_pos.x, camera_pos.y, camera_pos.z));
+  cv::Vec3d rvec;
+  cv::Rodrigues(rotation, rvec);
+  Pose3D pose;
+  for (int idx = 0; idx < 3; idx++)
+  {
+    pose.add_rotation(rvec[idx]);
+    pose.add_translation(translation[idx]);
+  }
+  return pose;
+}
+
+IntrinsicParameters buildIntrinsic(int width, int height, int distortion_size)
+{
+  std::vector<double> coefficients = { -0.25, 0.08, 0.001, -0.0005, -0.01, 0.02, -0.005, 0.001 };
+  if (distortion_size < 0 || distortion_size > (int)coefficients.size())
+  {
+    throw std::runtime_error(HL_DEBUG + "unsupported number of distortion coefficients: " +
+                             std::to_string(distortion_size));
+  }
+  IntrinsicParameters intrinsic;
+  intrinsic.set_focal_x(0.55 * width);
+  intrinsic.set_focal_y(0.55 * width);
+  intrinsic.set_center_x(width / 2);
+  intrinsic.set_center_y(height / 2);
+  intrinsic.set_img_width(width);
+  intrinsic.set_img_height(height);
+  for (int idx = 0; idx < distortion_size; idx++)
+  {
+    intrinsic.add_distortion(coefficients[idx]);
+  }
+  return intrinsic;
+}
+
+struct Robot
+{
+  uint32_t team_id;
+  uint32_t robot_id;
+  cv::Point2f pos;
+  cv::Point2f speed;
+  /**
+   * Position at the previous simulation step
+   */
+  cv::Point2f previous_pos;
+};
+
+int main(int argc, char** argv)
+{
+  TCLAP::CmdLine cmd("Render a synthetic recording with ground truth", ' ', "0.9");
+  TCLAP::ValueArg<std::string> prefix_arg("o", "output", "Prefix of the output files", false, "synthetic", "string",
+                                          cmd);
+  TCLAP::ValueArg<int> seed_arg("s", "seed", "Seed of the random generators", false, 42, "int", cmd);
+  TCLAP::ValueArg<int> frames_arg("n", "nb_frames", "Number of frames of the video", false, 300, "int", cmd);
+  TCLAP::ValueArg<double> fps_arg("f", "fps", "Frame rate of the video", false, 30, "double", cmd);
+  TCLAP::ValueArg<int> width_arg("W", "width", "Width of the images", false, 1280, "int", cmd);
+  TCLAP::ValueArg<int> height_arg("H", "height", "Height of the images", false, 720, "int", cmd);
+  TCLAP::ValueArg<int> distortion_arg("d", "distortion", "Number of distortion coefficients (0 to 8)", false, 5,
+                                      "int", cmd);
+  TCLAP::ValueArg<int> robots_arg("r", "robots", "Number of robots per team", false, 4, "int", cmd);
+  TCLAP::ValueArg<uint64_t> start_arg("t", "start", "time_stamp of the first frame [us]", false, 1000000000, "us",
+                                      cmd);
+  TCLAP::ValueArg<int> jitter_arg("j", "jitter", "Maximal jitter of the time_stamps of frames [us]", false, 0, "us",
+                                  cmd);
+  TCLAP::ValueArg<double> noise_arg("g", "noise", "Standard deviation of the gaussian noise added to images", false,
+                                    0, "double", cmd);
+  TCLAP::SwitchArg moving_arg("m", "moving", "The camera pans along the field, a pose is written for each frame", cmd,
+                              false);
+  TCLAP::ValueArg<std::string> field_arg("", "field", "The path to the json description of the field", false, "",
+                                         "path", cmd);
+  try
+  {
+    cmd.parse(argc, argv);
+  }
+  catch (const TCLAP::ArgException& e)
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  int nb_frames = frames_arg.getValue();
+  double fps = fps_arg.getValue();
+  cv::Size img_size(width_arg.getValue(), height_arg.getValue());
+  uint64_t start = start_arg.getValue();
+  double frame_period = 1e6 / fps;
+  if (jitter_arg.getValue() < 0 || 2 * jitter_arg.getValue() >= frame_period)
+  {
+    throw std::runtime_error(HL_DEBUG + "jitter should be positive and lower than half the frame period");
+  }
+
+  Field field;
+  if (field_arg.getValue() != "")
+  {
+    field.loadFile(field_arg.getValue());
+  }
+
+  std::mt19937 engine(seed_arg.getValue());
+  cv::RNG img_rng(seed_arg.getValue());
+  std::uniform_int_distribution<int> jitter_distrib(-jitter_arg.getValue(), jitter_arg.getValue());
+
+  // Camera is in the team area, looking at the center of the field
+  cv::Point3d camera_pos(0, -field.getArenaWidth() / 2 - 1.0, 2.5);
+  CameraMetaInformation camera_meta;
+  camera_meta.mutable_camera_parameters()->CopyFrom(
+      buildIntrinsic(img_size.width, img_size.height, distortion_arg.getValue()));
+  camera_meta.mutable_pose()->CopyFrom(lookAt(camera_pos, cv::Point3d(0, 0, 0)));
+
+  VideoMetaInformation header;
+  header.mutable_camera_parameters()->CopyFrom(camera_meta.camera_parameters());
+  header.mutable_default_pose()->CopyFrom(camera_meta.pose());
+  header.set_time_offset(0);
+
+  MetaInformationWriter meta_writer(prefix_arg.getValue() + ".bin");
+  meta_writer.writeHeader(header);
+  cv::VideoWriter video_writer(prefix_arg.getValue() + ".avi", cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps,
+                               img_size);
+  if (!video_writer.isOpened())
+  {
+    throw std::runtime_error(HL_DEBUG + "failed to open video '" + prefix_arg.getValue() + ".avi'");
+  }
+
+  std::vector<Robot> robots;
+  std::uniform_real_distribution<float> x_distrib(-field.field_length / 2, field.field_length / 2);
+  std::uniform_real_distribution<float> y_distrib(-field.field_width / 2, field.field_width / 2);
+  std::normal_distribution<float> acc_distrib(0, 0.05);
+  for (uint32_t team_id : { 1, 2 })
+  {
+    for (int robot_id = 1; robot_id <= robots_arg.getValue(); robot_id++)
+    {
+      cv::Point2f pos(x_distrib(engine), y_distrib(engine));
+      robots.push_back({ team_id, (uint32_t)robot_id, pos, cv::Point2f(0, 0), pos });
+    }
+  }
+  std::vector<cv::Scalar> team_colors = { cv::Scalar(255, 255, 0), cv::Scalar(255, 0, 255) };
+
+  GameMsgCollection messages;
+  // GameController messages at 2 Hz, robot messages at 10Hz
+  uint64_t gc_period = 500 * 1000;
+  uint64_t robot_period = 100 * 1000;
+  uint64_t next_gc_msg = start;
+  uint64_t next_robot_msg = start;
+
+  cv::Mat img(img_size, CV_8UC3), noise(img_size, CV_16SC3);
+  std::vector<cv::Point3f> robots_in_field(robots.size());
+  std::vector<cv::Point2f> robots_in_img(robots.size());
+  std::vector<uint8_t> robots_visible(robots.size());
+  uint64_t previous_sim_time = start;
+  for (int frame_idx = 0; frame_idx < nb_frames; frame_idx++)
+  {
+    double elapsed = frame_idx / fps;
+    uint64_t sim_time = start + (uint64_t)std::llround(frame_idx * frame_period);
+    uint64_t time_stamp = sim_time + jitter_distrib(engine);
+
+    // Robots follow a random walk, bouncing on the borders of the field. Speed
+    // is only reversed while moving outward, otherwise a robot which is still
+    // outside after a step would oscillate on the border.
+    for (Robot& robot : robots)
+    {
+      robot.previous_pos = robot.pos;
+      if (frame_idx == 0)
+      {
+        continue;
+      }
+      robot.speed += cv::Point2f(acc_distrib(engine), acc_distrib(engine));
+      robot.speed *= std::min(1.0, 0.5 / std::max(cv::norm(robot.speed), 1e-6));
+      robot.pos += robot.speed * (1 / fps);
+      if ((robot.pos.x > field.field_length / 2 && robot.speed.x > 0) ||
+          (robot.pos.x < -field.field_length / 2 && robot.speed.x < 0))
+      {
+        robot.speed.x = -robot.speed.x;
+      }
+      if ((robot.pos.y > field.field_width / 2 && robot.speed.y > 0) ||
+          (robot.pos.y < -field.field_width / 2 && robot.speed.y < 0))
+      {
+        robot.speed.y = -robot.speed.y;
+      }
+    }
+
+    FrameEntry frame;
+    frame.set_time_stamp(time_stamp);
+    if (moving_arg.getValue())
+    {
+      double period = 10.0;
+      cv::Point3d target(field.field_length / 4 * std::sin(2 * M_PI * elapsed / period), 0, 0);
+      camera_meta.mutable_pose()->CopyFrom(lookAt(camera_pos, target));
+      frame.mutable_pose()->CopyFrom(camera_meta.pose());
+    }
+    CameraModel model(camera_meta);
+
+    img.setTo(cv::Scalar(0, 100, 0));
+    field.tagLines(model, &img, cv::Scalar(255, 255, 255), 2.0, 10);
+    for (size_t idx = 0; idx < robots.size(); idx++)
+    {
+      robots_in_field[idx] = cv::Point3f(robots[idx].pos.x, robots[idx].pos.y, 0);
+    }
+    model.fieldToImg(robots_in_field.data(), robots.size(), robots_in_img.data(), robots_visible.data());
+    for (size_t idx = 0; idx < robots.size(); idx++)
+    {
+      if (robots_visible[idx])
+      {
+        cv::circle(img, robots_in_img[idx], 8, team_colors[robots[idx].team_id - 1], cv::FILLED);
+      }
+    }
+    if (noise_arg.getValue() > 0)
+    {
+      img_rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(noise_arg.getValue()));
+      cv::add(img, noise, img, cv::noArray(), CV_8UC3);
+    }
+    video_writer.write(img);
+    meta_writer.writeFrame(frame);
+
+    while (next_gc_msg <= sim_time)
+    {
+      GCMsg* gc_msg = messages.add_gc_msg();
+      gc_msg->set_time_stamp(next_gc_msg);
+      for (uint32_t team_id : { 1, 2 })
+      {
+        GCTeamMsg* team_msg = gc_msg->add_teams();
+        team_msg->set_team_number(team_id);
+        team_msg->set_team_color(team_id - 1);
+      }
+      next_gc_msg += gc_period;
+    }
+    // Messages sent since the previous step carry the positions interpolated at their time_stamp
+    while (next_robot_msg <= sim_time)
+    {
+      float ratio = 1;
+      if (sim_time > previous_sim_time)
+      {
+        ratio = (next_robot_msg - previous_sim_time) / (float)(sim_time - previous_sim_time);
+      }
+      for (const Robot& robot : robots)
+      {
+        cv::Point2f pos = robot.previous_pos + ratio * (robot.pos - robot.previous_pos);
+        RobotMsg* robot_msg = messages.add_robot_msg();
+        robot_msg->set_time_stamp(next_robot_msg);
+        robot_msg->mutable_robot_id()->set_team_id(robot.team_id);
+        robot_msg->mutable_robot_id()->set_robot_id(robot.robot_id);
+        WeightedPose* self_in_field = robot_msg->mutable_perception()->add_self_in_field();
+        self_in_field->set_probability(1.0);
+        PositionDistribution* position = self_in_field->mutable_pose()->mutable_position();
+        position->set_x(pos.x);
+        position->set_y(pos.y);
+      }
+      next_robot_msg += robot_period;
+    }
+    previous_sim_time = sim_time;
+  }
+  meta_writer.close();
+  writeToFile(prefix_arg.getValue() + "_messages.bin", messages);
+  std::cout << "Wrote " << nb_frames << " frames and " << (messages.gc_msg_size() + messages.robot_msg_size())
+            << " messages" << std::endl;
+}
@@ -15,8 +15,12 @@ int main(int argc, char** argv)
 
   TCLAP::ValueArg<std::string> video_arg("i", "input", "The path to the input", true, "/dev/video0", "string");
   TCLAP::ValueArg<std::string> output_arg("o", "output", "The path to the output video", true, "output.avi", "string");
+  TCLAP::ValueArg<std::string> encoder_arg("e", "encoder",
+                                           "The encoder preset: legacy, fast_lossless, cheap_intra or compact", false,
+                                           "legacy", "string");
   cmd.add(video_arg);
   cmd.add(output_arg);
+  cmd.add(encoder_arg);
 
   try
   {
@@ -27,7 +31,8 @@ int main(int argc, char** argv)
     std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
   }
 
-  OpenCVImageProvider provider(video_arg.getValue(), output_arg.getValue());
+  OpenCVImageProvider provider(video_arg.getValue(), output_arg.getValue(),
+                               EncoderSettings::getPreset(encoder_arg.getValue()));
 
   bool exit = false;
 